@@ -43,6 +43,9 @@
 #include "property.h"
 #include "screen.h"
 #include "luaa.h"
+#include "luagc.h"
+#include "luacache.h"
+#include "restart.h"
 #include "common/version.h"
 #include "common/atoms.h"
 #include "common/xcursor.h"
@@ -62,6 +65,10 @@ awesome_atexit(bool restart)
     lua_pushboolean(globalconf.L, restart);
     signal_object_emit(globalconf.L, &global_signals, "exit", 1);
 
+    /* Hand the clients over to the next instance */
+    if(restart)
+        restart_save();
+
     a_dbus_cleanup();
 
     systray_cleanup();
@@ -156,12 +163,33 @@ static void
 a_refresh_cb(EV_P_ ev_prepare *w, int revents)
 {
     awesome_refresh();
+    profiler_record_iteration();
+}
+
+/** Handle an X event, timing it if the profiler is recording.
+ * \param event The event.
+ */
+static void
+a_xcb_event_handle(xcb_generic_event_t *event)
+{
+    if(profiler_enabled)
+    {
+        ev_tstamp start = ev_time();
+        uint8_t type = XCB_EVENT_RESPONSE_TYPE(event);
+        event_handle(event);
+        profiler_record_event(type, ev_time() - start);
+    }
+    else
+        event_handle(event);
 }
 
 static void
 a_xcb_check_cb(EV_P_ ev_check *w, int revents)
 {
     xcb_generic_event_t *mouse = NULL, *event;
+    const char *phase = xtrace_enter("event dispatch");
+
+    profiler_begin();
 
     while((event = xcb_poll_for_event(globalconf.connection)))
     {
@@ -181,20 +209,23 @@ a_xcb_check_cb(EV_P_ ev_check *w, int revents)
             {
                 /* Make sure enter/motion/leave events are handled in the
                  * correct order */
-                event_handle(mouse);
+                a_xcb_event_handle(mouse);
                 p_delete(&mouse);
                 mouse = NULL;
             }
-            event_handle(event);
+            a_xcb_event_handle(event);
             p_delete(&event);
         }
     }
 
     if(mouse)
     {
-        event_handle(mouse);
+        a_xcb_event_handle(mouse);
         p_delete(&mouse);
     }
+
+    profiler_mark(PROFILER_PHASE_DISPATCH);
+    xtrace_leave(phase);
 }
 
 static void
@@ -253,7 +284,8 @@ exit_help(int exit_code)
   -h, --help             show help\n\
   -v, --version          show version\n\
   -c, --config FILE      configuration file to use\n\
-  -k, --check            check configuration file syntax\n");
+  -k, --check            check configuration file syntax\n\
+  -b, --no-bytecode-cache  do not cache compiled Lua files\n");
     exit(exit_code);
 }
 
@@ -279,6 +311,7 @@ main(int argc, char **argv)
         { "config",  1, NULL, 'c' },
         { "check",   0, NULL, 'k' },
         { "no-argb", 0, NULL, 'a' },
+        { "no-bytecode-cache", 0, NULL, 'b' },
         { NULL,      0, NULL, 0 }
     };
 
@@ -318,8 +351,11 @@ main(int argc, char **argv)
     /* init lua */
     luaA_init(&xdg);
 
+    /* read the state handed over by the previous instance, if restarting */
+    restart_load();
+
     /* check args */
-    while((opt = getopt_long(argc, argv, "vhkc:a",
+    while((opt = getopt_long(argc, argv, "vhkc:ab",
                              long_options, NULL)) != -1)
         switch(opt)
         {
@@ -349,6 +385,9 @@ main(int argc, char **argv)
           case 'a':
             no_argb = true;
             break;
+          case 'b':
+            luacache_enabled = false;
+            break;
         }
 
     globalconf.loop = ev_default_loop(EVFLAG_NOSIGFD);
@@ -443,6 +482,9 @@ main(int argc, char **argv)
     if (xcb_poll_for_event(globalconf.connection) != NULL)
         fatal("another window manager is already running");
 
+    /* Do not miss property changes of the clients we are restoring */
+    restart_watch();
+
     /* Prefetch the maximum request length */
     xcb_prefetch_maximum_request_length(globalconf.connection);
 
@@ -516,8 +558,14 @@ main(int argc, char **argv)
     /* scan existing windows */
     scan(tree_c);
 
+    /* the clients not found again are gone */
+    restart_wipe();
+
     xcb_flush(globalconf.connection);
 
+    /* collect Lua garbage when idle */
+    luagc_init();
+
     /* main event loop */
     ev_loop(globalconf.loop, 0);
 
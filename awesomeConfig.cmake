@@ -14,6 +14,8 @@ option(WITH_DBUS "build with D-BUS" ON)
 option(GENERATE_MANPAGES "generate manpages" ON)
 option(COMPRESS_MANPAGES "compress manpages" ON)
 option(GENERATE_LUADOC "generate luadoc" ON)
+option(WITH_XCB_TRACE "count X requests and round trips per call site (debugging)" OFF)
+option(WITH_LUAJIT "build against LuaJIT instead of Lua" OFF)
 
 # {{{ CFLAGS
 add_definitions(-std=gnu99 -ggdb3 -rdynamic -fno-strict-aliasing -Wall -Wextra
@@ -62,7 +64,18 @@ include(FindDoxygen)
 # pkg-config
 include(FindPkgConfig)
 # lua 5.1
-include(FindLua51) #Due to a cmake bug, you will see Lua50 on screen
+if(WITH_LUAJIT)
+    pkg_check_modules(LUAJIT luajit)
+    if(LUAJIT_FOUND)
+        set(LUA51_FOUND TRUE)
+        set(LUA_INCLUDE_DIR ${LUAJIT_INCLUDE_DIRS})
+        set(LUA_LIBRARIES ${LUAJIT_LDFLAGS})
+    else()
+        message(FATAL_ERROR "LuaJIT not found")
+    endif()
+else()
+    include(FindLua51) #Due to a cmake bug, you will see Lua50 on screen
+endif()
 # }}}
 
 # {{{ Check if documentation can be build
@@ -187,6 +200,13 @@ else()
     message(STATUS "checking for __builtin_clz -- no")
 endif()
 
+# Check for inotify, used to watch directories
+include(CheckIncludeFile)
+check_include_file(sys/inotify.h HAS_INOTIFY)
+
+# Check for memfd_create, used to hand the state over on restart
+check_function_exists(memfd_create HAS_MEMFD_CREATE)
+
 # Error check
 if(NOT LUA51_FOUND AND NOT LUA50_FOUND) # This is a workaround to a cmake bug
     message(FATAL_ERROR "lua library not found")
@@ -220,6 +240,15 @@ if(WITH_DBUS)
         message(STATUS "DBUS not found. Disabled.")
     endif()
 endif()
+
+if(WITH_XCB_TRACE)
+    if(HAS_EXECINFO)
+        set(AWESOME_OPTIONAL_LDFLAGS ${AWESOME_OPTIONAL_LDFLAGS} ${CMAKE_DL_LIBS})
+    else()
+        set(WITH_XCB_TRACE OFF)
+        message(STATUS "execinfo not found. X request tracing disabled.")
+    endif()
+endif()
 # }}}
 
 # {{{ Install path and configuration variables
@@ -0,0 +1,208 @@
+/*
+ * bench-client.c - synthetic X client for the benchmark harness
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+/* This program maps a number of windows with titles, icons and struts,
+ * optionally changes their titles in a tight loop once they are mapped, and
+ * then either exits or stays around until the X connection breaks.
+ * It only depends on libxcb so it can be run against any X server.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <xcb/xcb.h>
+
+#define ICON_SIZE 32
+
+static xcb_connection_t *connection;
+
+static xcb_atom_t
+intern_atom(const char *name)
+{
+    xcb_intern_atom_reply_t *reply =
+        xcb_intern_atom_reply(connection,
+                              xcb_intern_atom(connection, false, strlen(name), name),
+                              NULL);
+    xcb_atom_t atom = reply ? reply->atom : XCB_NONE;
+    free(reply);
+    return atom;
+}
+
+static void
+set_title(xcb_window_t win, xcb_atom_t net_wm_name, xcb_atom_t utf8_string,
+          const char *title)
+{
+    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, win,
+                        XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8,
+                        strlen(title), title);
+    xcb_change_property(connection, XCB_PROP_MODE_REPLACE, win,
+                        net_wm_name, utf8_string, 8,
+                        strlen(title), title);
+}
+
+static void
+usage(const char *name)
+{
+    fprintf(stderr,
+            "Usage: %s [-n windows] [-t title updates] [-d delay] [-i] [-s] [-q]\n"
+            "  -n  number of windows to map (default 1)\n"
+            "  -t  number of title changes per window once mapped (default 0)\n"
+            "  -d  delay between two rounds of title changes, in microseconds\n"
+            "  -i  set an icon on every window\n"
+            "  -s  set a strut on the first window\n"
+            "  -q  exit once done instead of waiting for the connection to break\n",
+            name);
+    exit(EXIT_FAILURE);
+}
+
+int
+main(int argc, char **argv)
+{
+    int opt, nwindows = 1, ntitles = 0, delay = 0, mapped = 0;
+    bool icon = false, strut = false, quit = false;
+    xcb_window_t *windows;
+    xcb_generic_event_t *event;
+    xcb_screen_t *screen;
+    xcb_atom_t net_wm_name, utf8_string;
+    char title[64];
+
+    while((opt = getopt(argc, argv, "n:t:d:isqh")) != -1)
+        switch(opt)
+        {
+          case 'n':
+            nwindows = atoi(optarg);
+            break;
+          case 't':
+            ntitles = atoi(optarg);
+            break;
+          case 'd':
+            delay = atoi(optarg);
+            break;
+          case 'i':
+            icon = true;
+            break;
+          case 's':
+            strut = true;
+            break;
+          case 'q':
+            quit = true;
+            break;
+          default:
+            usage(argv[0]);
+        }
+
+    if(nwindows <= 0)
+        usage(argv[0]);
+
+    connection = xcb_connect(NULL, NULL);
+    if(xcb_connection_has_error(connection))
+    {
+        fprintf(stderr, "cannot open display\n");
+        return EXIT_FAILURE;
+    }
+
+    screen = xcb_setup_roots_iterator(xcb_get_setup(connection)).data;
+    net_wm_name = intern_atom("_NET_WM_NAME");
+    utf8_string = intern_atom("UTF8_STRING");
+
+    windows = calloc(nwindows, sizeof(*windows));
+    for(int i = 0; i < nwindows; i++)
+    {
+        xcb_window_t win = windows[i] = xcb_generate_id(connection);
+
+        xcb_create_window(connection, XCB_COPY_FROM_PARENT, win, screen->root,
+                          0, 0, 200, 100, 0, XCB_WINDOW_CLASS_INPUT_OUTPUT,
+                          XCB_COPY_FROM_PARENT,
+                          XCB_CW_BACK_PIXEL | XCB_CW_EVENT_MASK,
+                          (const uint32_t []) { screen->white_pixel, XCB_EVENT_MASK_STRUCTURE_NOTIFY });
+
+        snprintf(title, sizeof(title), "bench %d", i);
+        set_title(win, net_wm_name, utf8_string, title);
+        xcb_change_property(connection, XCB_PROP_MODE_REPLACE, win,
+                            XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8,
+                            sizeof("bench-client\0BenchClient"),
+                            "bench-client\0BenchClient");
+    }
+
+    if(icon)
+    {
+        xcb_atom_t net_wm_icon = intern_atom("_NET_WM_ICON");
+        uint32_t data[2 + ICON_SIZE * ICON_SIZE];
+
+        data[0] = data[1] = ICON_SIZE;
+        for(int i = 0; i < ICON_SIZE * ICON_SIZE; i++)
+            data[2 + i] = 0xff000000 | (i * 0x10101);
+
+        for(int i = 0; i < nwindows; i++)
+            xcb_change_property(connection, XCB_PROP_MODE_REPLACE, windows[i],
+                                net_wm_icon, XCB_ATOM_CARDINAL, 32,
+                                2 + ICON_SIZE * ICON_SIZE, data);
+    }
+
+    if(strut)
+    {
+        /* 20 pixels at the top of the screen */
+        uint32_t data[12] = { 0, 0, 20, 0, 0, 0, 0, 0, 0, screen->width_in_pixels - 1, 0, 0 };
+
+        xcb_change_property(connection, XCB_PROP_MODE_REPLACE, windows[0],
+                            intern_atom("_NET_WM_STRUT_PARTIAL"), XCB_ATOM_CARDINAL, 32,
+                            12, data);
+    }
+
+    for(int i = 0; i < nwindows; i++)
+        xcb_map_window(connection, windows[i]);
+    xcb_flush(connection);
+
+    /* Only start changing titles once the window manager mapped all windows,
+     * so that every change reaches a managed client */
+    while(ntitles > 0 && mapped < nwindows && (event = xcb_wait_for_event(connection)))
+    {
+        if((event->response_type & ~0x80) == XCB_MAP_NOTIFY)
+            mapped++;
+        free(event);
+    }
+
+    for(int round = 0; round < ntitles; round++)
+    {
+        for(int i = 0; i < nwindows; i++)
+        {
+            snprintf(title, sizeof(title), "bench %d title %d", i, round);
+            set_title(windows[i], net_wm_name, utf8_string, title);
+        }
+        xcb_flush(connection);
+        if(delay > 0)
+            usleep(delay);
+    }
+
+    xcb_flush(connection);
+
+    if(!quit)
+        while((event = xcb_wait_for_event(connection)))
+            free(event);
+
+    free(windows);
+    xcb_disconnect(connection);
+    return EXIT_SUCCESS;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,92 @@
+#!/bin/sh
+#
+# Run the benchmark scenarios against a headless Xvfb server.
+#
+# $1 the source directory
+# $2 the build directory, containing awesome, bench-client and lib/
+#
+# Environment:
+#   BENCH_CLIENTS     number of windows to manage (default 50)
+#   BENCH_ITERATIONS  number of steps per scenario (default 100)
+#   BENCH_RESTARTS    number of restarts to time (default 5)
+#   BENCH_ONLY        only run the named scenario
+#   BENCH_DISPLAY     display number for Xvfb (default :42)
+#   BENCH_COMPARE     another build directory to run the same scenarios with,
+#                     e.g. one configured with -DWITH_LUAJIT=ON
+
+set -e
+
+SOURCE_DIR=$1
+BUILD_DIR=$2
+DISPLAY_NUM=${BENCH_DISPLAY:-:42}
+
+XVFB=$(which Xvfb 2>/dev/null || true)
+if [ -z "$XVFB" ]
+then
+    echo "Xvfb is required to run the benchmark" >&2
+    exit 1
+fi
+
+DIR=$(mktemp -d "${TMPDIR:-/tmp}/awesome-benchmark.XXXXXX")
+trap 'kill $XVFB_PID 2>/dev/null; rm -rf "$DIR"' EXIT INT TERM
+
+if [ -n "$BENCH_ONLY" ]
+then
+    ONLY="\"$BENCH_ONLY\""
+else
+    ONLY=nil
+fi
+
+"$XVFB" "$DISPLAY_NUM" -screen 0 1920x1080x24 -nolisten tcp 2>"$DIR/xvfb.log" &
+XVFB_PID=$!
+
+# Wait for the server to accept connections
+tries=0
+while [ ! -e "/tmp/.X11-unix/X${DISPLAY_NUM#:}" ]
+do
+    tries=$((tries + 1))
+    if [ $tries -gt 50 ]
+    then
+        echo "Xvfb did not start:" >&2
+        cat "$DIR/xvfb.log" >&2
+        exit 1
+    fi
+    sleep 0.1
+done
+
+# Run the scenarios with the awesome of the build directory $1
+run()
+{
+    rm -f "$DIR/results.txt" "$DIR/restart.latencies"
+    cat > "$DIR/rc.lua" <<EOF
+package.path = "$1/lib/?.lua;$1/lib/?/init.lua;" .. package.path
+benchmark = {
+    dir = "$DIR",
+    client = "$1/bench-client",
+    clients = ${BENCH_CLIENTS:-50},
+    iterations = ${BENCH_ITERATIONS:-100},
+    restarts = ${BENCH_RESTARTS:-5},
+    only = $ONLY
+}
+dofile("$SOURCE_DIR/benchmark/scenarios.lua")
+EOF
+
+    DISPLAY=$DISPLAY_NUM "$1/awesome" -c "$DIR/rc.lua" 2>"$DIR/awesome.log" || true
+
+    if [ ! -s "$DIR/results.txt" ]
+    then
+        echo "The benchmark did not produce any result:" >&2
+        cat "$DIR/awesome.log" >&2
+        exit 1
+    fi
+
+    echo "== $1"
+    cat "$DIR/results.txt"
+}
+
+run "$BUILD_DIR"
+if [ -n "$BENCH_COMPARE" ]
+then
+    echo
+    run "$BENCH_COMPARE"
+fi
@@ -0,0 +1,222 @@
+---------------------------------------------------------------------------
+-- @author awesome developers
+-- @copyright 2013 awesome developers
+---------------------------------------------------------------------------
+
+-- Benchmark scenarios, loaded by the rc.lua generated by benchmark/run.sh.
+-- The generated file defines the global benchmark table with the settings:
+-- dir (output directory), client (path to bench-client), clients (number of
+-- windows to manage), iterations (steps per scenario) and restarts.
+-- Each scenario runs in a coroutine and yields to the main loop between
+-- steps, so that every step includes the refresh it triggers.
+
+local awful = require("awful")
+local naughty = require("naughty")
+local GLib = require("lgi").GLib
+
+local settings = benchmark
+local results_file = settings.dir .. "/results.txt"
+local state_file = settings.dir .. "/restart.state"
+
+local function now()
+    return GLib.get_monotonic_time() / 1000
+end
+
+local function output(line)
+    local f = io.open(results_file, "a")
+    f:write(line, "\n")
+    f:close()
+end
+
+local current
+
+--- Resume the running scenario from a callback.
+local function resume(...)
+    local ok, err = coroutine.resume(current, ...)
+    if not ok then
+        output("error: " .. tostring(err))
+        awesome.quit()
+    end
+end
+
+--- Wait for the given number of seconds, at least one main loop iteration.
+local function sleep(seconds)
+    local t = timer({ timeout = seconds })
+    t:connect_signal("timeout", function()
+        t:stop()
+        resume()
+    end)
+    t:start()
+    coroutine.yield()
+end
+
+--- Wait until a client signal fired count times.
+local function wait_clients(signal, count, filter)
+    local seen = 0
+    local function handler(c)
+        if filter and not filter(c) then return end
+        seen = seen + 1
+        if seen == count then
+            client.disconnect_signal(signal, handler)
+            resume()
+        end
+    end
+    client.connect_signal(signal, handler)
+    coroutine.yield()
+end
+
+local function is_bench(c)
+    return c.class == "BenchClient"
+end
+
+local function spawn_clients(args)
+    awful.util.spawn(settings.client .. " " .. args, false)
+end
+
+--- Summarize the latencies of a scenario and the profiler data of its run.
+local function report(name, latencies)
+    local requests, events = 0, 0
+    for _, sample in ipairs(awesome.profiler.samples()) do
+        requests = requests + sample.requests
+        events = events + sample.events
+    end
+    local p = awful.profiler.percentiles(latencies, { 50, 90, 99, 100 })
+    output(string.format("%-16s %6d %9.3f %9.3f %9.3f %9.3f %9d %9d",
+                         name, #latencies, p[50], p[90], p[99], p[100],
+                         requests, events))
+end
+
+--- Run a scenario, timing each call to step().
+local function measure(name, body)
+    local latencies = {}
+    awesome.profiler.start(100000)
+    body(function(action)
+        local start = now()
+        action()
+        sleep(0)
+        table.insert(latencies, now() - start)
+    end)
+    awesome.profiler.stop()
+    report(name, latencies)
+end
+
+local scenarios = {}
+
+function scenarios.manage()
+    measure("manage", function(step)
+        step(function()
+            spawn_clients("-i -s -n " .. settings.clients)
+            wait_clients("manage", settings.clients, is_bench)
+        end)
+    end)
+end
+
+function scenarios.tag_switch()
+    measure("tag_switch", function(step)
+        for i = 1, settings.iterations do
+            step(function() awful.tag.viewnext() end)
+        end
+    end)
+    awful.tag.viewonly(awful.tag.gettags(1)[1])
+end
+
+function scenarios.tile()
+    local layouts = { awful.layout.suit.tile, awful.layout.suit.fair,
+                      awful.layout.suit.tile.bottom, awful.layout.suit.spiral }
+    measure("tile", function(step)
+        for i = 1, settings.iterations do
+            step(function() awful.layout.set(layouts[i % #layouts + 1]) end)
+        end
+    end)
+    measure("mwfact", function(step)
+        for i = 1, settings.iterations do
+            step(function() awful.tag.incmwfact(i % 2 == 0 and 0.01 or -0.01) end)
+        end
+    end)
+end
+
+function scenarios.title_storm()
+    local windows = 10
+    measure("title_storm", function(step)
+        step(function()
+            spawn_clients("-q -n " .. windows .. " -t " .. settings.iterations)
+            wait_clients("unmanage", windows, is_bench)
+        end)
+    end)
+end
+
+function scenarios.notifications()
+    local shown = {}
+    measure("notifications", function(step)
+        for i = 1, settings.iterations do
+            step(function()
+                table.insert(shown, naughty.notify({ title = "bench", text = "notification " .. i,
+                                                     timeout = 0 }))
+            end)
+        end
+        for _, n in ipairs(shown) do
+            step(function() naughty.destroy(n) end)
+        end
+    end)
+end
+
+function scenarios.restart()
+    local f = io.open(state_file, "w")
+    f:write(string.format("return { remaining = %d, start = %f }\n",
+                          settings.restarts, now()))
+    f:close()
+    awesome.restart()
+end
+
+--- Called after a restart, with the state saved before it.
+local function restarted(state)
+    local latency = now() - state.start
+    local f = io.open(settings.dir .. "/restart.latencies", "a")
+    f:write(latency, "\n")
+    f:close()
+
+    if state.remaining > 1 then
+        f = io.open(state_file, "w")
+        f:write(string.format("return { remaining = %d, start = %f }\n",
+                              state.remaining - 1, now()))
+        f:close()
+        awesome.restart()
+        return
+    end
+
+    os.remove(state_file)
+    local latencies = {}
+    for line in io.lines(settings.dir .. "/restart.latencies") do
+        table.insert(latencies, tonumber(line))
+    end
+    awesome.profiler.reset()
+    report("restart", latencies)
+    awesome.quit()
+end
+
+local order = { "manage", "tag_switch", "tile", "title_storm", "notifications", "restart" }
+
+awful.tag.new({ 1, 2, 3, 4, 5, 6, 7, 8, 9 }, 1, awful.layout.suit.tile)
+
+current = coroutine.create(function()
+    local state = loadfile(state_file)
+    -- Let the startup finish before measuring anything
+    sleep(0)
+    if state then
+        return restarted(state())
+    end
+    output("runtime: " .. (jit and jit.version or _VERSION) ..
+           (require("awful.ffi").enabled and " with FFI accessors" or ""))
+    output(string.format("%-16s %6s %9s %9s %9s %9s %9s %9s",
+                         "scenario", "steps", "p50 ms", "p90 ms", "p99 ms", "max ms",
+                         "requests", "events"))
+    for _, name in ipairs(order) do
+        if not settings.only or settings.only == name then
+            scenarios[name]()
+        end
+    end
+    awesome.quit()
+end)
+resume()
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
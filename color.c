@@ -30,6 +30,77 @@
 #define RGB_8TO16(i) (((i) & 0xff)   * 0x101)
 #define RGB_16TO8(i) (((i) & 0xffff) / 0x101)
 
+/** An allocated color, keyed by its 0xRRGGBB value */
+typedef struct
+{
+    uint32_t rgb;
+    color_t color;
+} color_cache_entry_t;
+
+static int
+color_cache_entry_cmp(const void *a, const void *b)
+{
+    const color_cache_entry_t *x = a, *y = b;
+    return x->rgb > y->rgb ? 1 : (x->rgb < y->rgb ? -1 : 0);
+}
+
+DO_BARRAY(color_cache_entry_t, color_cache_entry, DO_NOTHING, color_cache_entry_cmp)
+
+/** The colors already allocated in the default colormap */
+static color_cache_entry_array_t color_cache;
+
+/** Scale a 16 bits color component to a visual mask.
+ * \param value The component value.
+ * \param mask The visual mask of the component.
+ * \return The component bits of the pixel.
+ */
+static uint32_t
+color_component_to_pixel(uint16_t value, uint32_t mask)
+{
+    int shift = 0, bits = 0;
+
+    if(!mask)
+        return 0;
+
+    while(!(mask & (1u << shift)))
+        shift++;
+    while(shift + bits < 32 && (mask & (1u << (shift + bits))))
+        bits++;
+
+    if(bits < 16)
+        value >>= 16 - bits;
+
+    return ((uint32_t) value << shift) & mask;
+}
+
+/** Compute a color's pixel without asking the X server.
+ * This is only possible for the visuals which map pixels to colors with
+ * fixed masks.
+ * \param color The color to fill, with its red, green and blue set.
+ * \return True if the pixel could be computed.
+ */
+static bool
+color_compute_pixel(color_t *color)
+{
+    xcb_visualtype_t *visual = globalconf.visual;
+    uint32_t depth_mask = globalconf.default_depth >= 32
+        ? 0xffffffff : (1u << globalconf.default_depth) - 1;
+
+    if(visual->_class != XCB_VISUAL_CLASS_TRUE_COLOR
+       && visual->_class != XCB_VISUAL_CLASS_DIRECT_COLOR)
+        return false;
+
+    color->pixel = color_component_to_pixel(color->red, visual->red_mask)
+        | color_component_to_pixel(color->green, visual->green_mask)
+        | color_component_to_pixel(color->blue, visual->blue_mask);
+    /* The other bits of the depth are the alpha channel of ARGB visuals:
+     * make the color opaque, like the server does for allocated colors */
+    color->pixel |= ~(visual->red_mask | visual->green_mask | visual->blue_mask) & depth_mask;
+    color->initialized = true;
+
+    return true;
+}
+
 /** Parse an hexadecimal color string to its component.
  * \param colstr The color string.
  * \param len The color string length.
@@ -69,6 +140,8 @@ color_parse(const char *colstr, ssize_t len,
 /** Send a request to initialize a X color.
  * If you are only interested in the rgba values and don't need the color's
  * pixel value, you should use color_init_unchecked() instead.
+ * On TrueColor and DirectColor visuals, and for colors already allocated,
+ * the color is initialized at once and no request is sent.
  * \param color color_t struct to store color into.
  * \param colstr Color specification.
  * \param len The length of colstr (which still MUST be NULL terminated).
@@ -98,15 +171,40 @@ color_init_unchecked(color_t *color, const char *colstr, ssize_t len)
         return req;
     }
 
+    req.has_error = false;
+    req.colstr = colstr;
+    req.rgb = (red << 16) | (green << 8) | blue;
+
+    color_cache_entry_t *cached =
+        color_cache_entry_array_lookup(&color_cache, &(color_cache_entry_t) { .rgb = req.rgb });
+
+    if(cached)
+    {
+        *color = cached->color;
+        req.resolved = true;
+        return req;
+    }
+
+    color_t computed =
+    {
+        .red = RGB_8TO16(red),
+        .green = RGB_8TO16(green),
+        .blue = RGB_8TO16(blue)
+    };
+
+    if(color_compute_pixel(&computed))
+    {
+        *color = computed;
+        req.resolved = true;
+        return req;
+    }
+
     req.cookie_hexa = xcb_alloc_color_unchecked(globalconf.connection,
                                                 globalconf.default_cmap,
                                                 RGB_8TO16(red),
                                                 RGB_8TO16(green),
                                                 RGB_8TO16(blue));
 
-    req.has_error = false;
-    req.colstr = colstr;
-
     return req;
 }
 
@@ -120,6 +218,9 @@ color_init_reply(color_init_request_t req)
     if(req.has_error)
         return false;
 
+    if(req.resolved)
+        return true;
+
     xcb_alloc_color_reply_t *hexa_color;
 
     if((hexa_color = xcb_alloc_color_reply(globalconf.connection,
@@ -131,6 +232,8 @@ color_init_reply(color_init_request_t req)
         req.color->blue  = hexa_color->blue;
         req.color->initialized = true;
         p_delete(&hexa_color);
+        color_cache_entry_array_insert(&color_cache,
+                                       (color_cache_entry_t) { .rgb = req.rgb, .color = *req.color });
         return true;
     }
 
@@ -41,6 +41,10 @@ typedef struct
     xcb_alloc_color_cookie_t cookie_hexa;
     color_t *color;
     bool has_error;
+    /** The color was found without asking the X server */
+    bool resolved;
+    /** The parsed color, as 0xRRGGBB */
+    uint32_t rgb;
     const char *colstr;
 } color_init_request_t;
 
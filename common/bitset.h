@@ -0,0 +1,117 @@
+/*
+ * bitset.h - growable bit set header
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_COMMON_BITSET_H
+#define AWESOME_COMMON_BITSET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "common/util.h"
+
+#define BITSET_WORD_BITS 32
+
+/** A set of small integers, stored as a growable array of bits */
+typedef struct
+{
+    uint32_t *words;
+    int len;
+} bitset_t;
+
+static inline void
+bitset_wipe(bitset_t *b)
+{
+    p_delete(&b->words);
+    b->len = 0;
+}
+
+/** Check if a bit is set.
+ * \param b The bit set.
+ * \param bit The bit number.
+ * \return True if the bit is set.
+ */
+static inline bool
+bitset_test(const bitset_t *b, int bit)
+{
+    int word = bit / BITSET_WORD_BITS;
+    return word < b->len
+        && (b->words[word] & (UINT32_C(1) << (bit % BITSET_WORD_BITS)));
+}
+
+/** Set a bit, growing the set if needed.
+ * \param b The bit set.
+ * \param bit The bit number.
+ */
+static inline void
+bitset_set(bitset_t *b, int bit)
+{
+    int word = bit / BITSET_WORD_BITS;
+    if(word >= b->len)
+    {
+        p_realloc(&b->words, word + 1);
+        p_clear(b->words + b->len, word + 1 - b->len);
+        b->len = word + 1;
+    }
+    b->words[word] |= UINT32_C(1) << (bit % BITSET_WORD_BITS);
+}
+
+/** Clear a bit.
+ * \param b The bit set.
+ * \param bit The bit number.
+ */
+static inline void
+bitset_clear(bitset_t *b, int bit)
+{
+    int word = bit / BITSET_WORD_BITS;
+    if(word < b->len)
+        b->words[word] &= ~(UINT32_C(1) << (bit % BITSET_WORD_BITS));
+}
+
+/** Check if two bit sets have at least one bit in common.
+ * \param a A bit set.
+ * \param b Another bit set.
+ * \return True if a bit is set in both.
+ */
+static inline bool
+bitset_intersects(const bitset_t *a, const bitset_t *b)
+{
+    int len = MIN(a->len, b->len);
+    for(int i = 0; i < len; i++)
+        if(a->words[i] & b->words[i])
+            return true;
+    return false;
+}
+
+/** Find the first bit which is not set.
+ * \param b The bit set.
+ * \return The number of the first cleared bit.
+ */
+static inline int
+bitset_first_clear(const bitset_t *b)
+{
+    int bit = 0;
+    while(bitset_test(b, bit))
+        bit++;
+    return bit;
+}
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -19,9 +19,166 @@
  *
  */
 
+#include <time.h>
+
 #include "common/luaobject.h"
 #include "common/backtrace.h"
 
+/** The cost of one signal handler */
+typedef struct
+{
+    /** The signal name hash */
+    unsigned long id;
+    /** The handler function */
+    const void *func;
+    /** The signal name */
+    char *signal;
+    /** Where the handler is defined, as source:line */
+    char *source;
+    /** Number of calls */
+    unsigned int calls;
+    /** Total and maximum CPU time spent, in seconds */
+    double time, max;
+    /** Lua memory allocated, in KiB */
+    double memory;
+} signal_profile_t;
+
+static inline int
+signal_profile_cmp(const void *a, const void *b)
+{
+    const signal_profile_t *x = a, *y = b;
+    if(x->id != y->id)
+        return x->id > y->id ? 1 : -1;
+    return x->func > y->func ? 1 : (x->func < y->func ? -1 : 0);
+}
+
+static inline void
+signal_profile_wipe(signal_profile_t *prof)
+{
+    p_delete(&prof->signal);
+    p_delete(&prof->source);
+}
+
+DO_BARRAY(signal_profile_t, signal_profile, signal_profile_wipe, signal_profile_cmp)
+
+bool signal_profiler_enabled = false;
+
+/** The cost of every signal handler called since the last reset */
+static signal_profile_array_t signal_profiles;
+
+/** Get the CPU time used by the process.
+ * \return The time in seconds.
+ */
+static double
+signal_profiler_cputime(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/** Get the memory used by Lua.
+ * \param L The Lua VM state.
+ * \return The memory in KiB.
+ */
+static double
+signal_profiler_memory(lua_State *L)
+{
+    return lua_gc(L, LUA_GCCOUNT, 0) + lua_gc(L, LUA_GCCOUNTB, 0) / 1024.0;
+}
+
+/** Call a signal handler, accounting its cost if the profiler is enabled.
+ * \param L The Lua VM state.
+ * \param id The signal name hash.
+ * \param name The signal name.
+ * \param nargs The number of arguments, below the function on the stack.
+ */
+static void
+signal_dofunction(lua_State *L, unsigned long id, const char *name, int nargs)
+{
+    if(!signal_profiler_enabled)
+    {
+        luaA_dofunction(L, nargs, 0);
+        return;
+    }
+
+    signal_profile_t key = { .id = id, .func = lua_topointer(L, -1) };
+    signal_profile_t *prof = signal_profile_array_lookup(&signal_profiles, &key);
+
+    if(!prof)
+    {
+        lua_Debug ar;
+        lua_pushvalue(L, -1);
+        lua_getinfo(L, ">S", &ar);
+        if(ar.linedefined > 0)
+            lua_pushfstring(L, "%s:%d", ar.short_src, ar.linedefined);
+        else
+            lua_pushstring(L, ar.short_src);
+        key.source = a_strdup(lua_tostring(L, -1));
+        lua_pop(L, 1);
+        key.signal = a_strdup(name);
+        signal_profile_array_insert(&signal_profiles, key);
+    }
+
+    double memory = signal_profiler_memory(L);
+    double start = signal_profiler_cputime();
+
+    luaA_dofunction(L, nargs, 0);
+
+    double elapsed = signal_profiler_cputime() - start;
+    memory = signal_profiler_memory(L) - memory;
+
+    /* The handler may have emitted signals itself, which can move entries
+     * around, or reset the profiler */
+    if(!(prof = signal_profile_array_lookup(&signal_profiles, &key)))
+        return;
+
+    prof->calls++;
+    prof->time += elapsed;
+    if(elapsed > prof->max)
+        prof->max = elapsed;
+    /* A garbage collection step during the call makes this negative */
+    if(memory > 0)
+        prof->memory += memory;
+}
+
+/** Forget the cost of all signal handlers.
+ */
+void
+signal_profiler_reset(void)
+{
+    signal_profile_array_wipe(&signal_profiles);
+    signal_profile_array_init(&signal_profiles);
+}
+
+/** Push the cost of all signal handlers called since the last reset.
+ * \param L The Lua VM state.
+ */
+void
+signal_profiler_push(lua_State *L)
+{
+    lua_createtable(L, signal_profiles.len, 0);
+    for(int i = 0; i < signal_profiles.len; i++)
+    {
+        signal_profile_t *prof = &signal_profiles.tab[i];
+
+        lua_createtable(L, 0, 6);
+        lua_pushstring(L, prof->signal);
+        lua_setfield(L, -2, "signal");
+        lua_pushstring(L, prof->source);
+        lua_setfield(L, -2, "source");
+        lua_pushnumber(L, prof->calls);
+        lua_setfield(L, -2, "calls");
+        lua_pushnumber(L, prof->time);
+        lua_setfield(L, -2, "time");
+        lua_pushnumber(L, prof->max);
+        lua_setfield(L, -2, "max");
+        lua_pushnumber(L, prof->memory);
+        lua_setfield(L, -2, "memory");
+        lua_rawseti(L, -2, i + 1);
+    }
+}
+
 /** Setup the object system at startup.
  * \param L The Lua VM state.
  */
@@ -212,8 +369,8 @@ luaA_object_disconnect_signal_from_stack(lua_State *L, int oud,
 void
 signal_object_emit(lua_State *L, signal_array_t *arr, const char *name, int nargs)
 {
-    signal_t *sigfound = signal_array_getbyid(arr,
-                                              a_strhash((const unsigned char *) name));
+    unsigned long id = a_strhash((const unsigned char *) name);
+    signal_t *sigfound = signal_array_getbyid(arr, id);
 
     if(sigfound)
     {
@@ -233,7 +390,7 @@ signal_object_emit(lua_State *L, signal_array_t *arr, const char *name, int narg
             lua_pushvalue(L, - nargs - nbfunc + i);
             /* remove this first function */
             lua_remove(L, - nargs - nbfunc - 1 + i);
-            luaA_dofunction(L, nargs, 0);
+            signal_dofunction(L, id, name, nargs);
         }
     } else
         warn("Trying to emit unknown signal '%s'", name);
@@ -258,8 +415,8 @@ luaA_object_emit_signal(lua_State *L, int oud,
         warn("Trying to emit signal '%s' on non-object", name);
         return;
     }
-    signal_t *sigfound = signal_array_getbyid(&obj->signals,
-                                              a_strhash((const unsigned char *) name));
+    unsigned long id = a_strhash((const unsigned char *) name);
+    signal_t *sigfound = signal_array_getbyid(&obj->signals, id);
     if(sigfound)
     {
         int nbfunc = sigfound->sigfuncs.len;
@@ -280,7 +437,7 @@ luaA_object_emit_signal(lua_State *L, int oud,
             lua_pushvalue(L, - nargs - nbfunc - 1 + i);
             /* remove this first function */
             lua_remove(L, - nargs - nbfunc - 2 + i);
-            luaA_dofunction(L, nargs + 1, 0);
+            signal_dofunction(L, id, name, nargs + 1);
         }
     } else
         warn("Trying to emit unknown signal '%s'", name);
@@ -151,6 +151,11 @@ luaA_object_push(lua_State *L, void *pointer)
 
 void signal_object_emit(lua_State *, signal_array_t *, const char *, int);
 
+/** Whether signal handlers are being profiled */
+extern bool signal_profiler_enabled;
+void signal_profiler_reset(void);
+void signal_profiler_push(lua_State *);
+
 void luaA_object_connect_signal(lua_State *, int, const char *, lua_CFunction);
 void luaA_object_disconnect_signal(lua_State *, int, const char *, lua_CFunction);
 void luaA_object_connect_signal_from_stack(lua_State *, int, const char *, int);
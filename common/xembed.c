@@ -134,11 +134,13 @@ xembed_property_update(xcb_connection_t *connection, xembed_window_t *emwin,
         if(info.flags & XEMBED_MAPPED)
         {
             xcb_map_window(connection, emwin->win);
+            emwin->mapped = true;
             xembed_window_activate(connection, emwin->win);
         }
         else
         {
             xcb_unmap_window(connection, emwin->win);
+            emwin->mapped = false;
             xembed_window_deactivate(connection, emwin->win);
             xembed_focus_out(connection, emwin->win);
         }
@@ -43,6 +43,11 @@ struct xembed_window
 {
     xcb_window_t win;
     xembed_info_t info;
+    /** Last geometry configured, size is 0 until configured */
+    int16_t x, y;
+    uint16_t size;
+    /** Whether the window was last mapped or unmapped by us */
+    bool mapped;
 };
 
 DO_ARRAY(xembed_window_t, xembed_window, DO_NOTHING)
@@ -38,18 +38,82 @@ static DBusConnection *dbus_connection_system = NULL;
 ev_io dbusio_ses = { .fd = -1 };
 ev_io dbusio_sys = { .fd = -1 };
 
+/** Default number of messages processed per bus and per main loop
+ * iteration */
+#define DBUS_DISPATCH_BUDGET 64
+
+/** Dispatching state of a bus */
+typedef struct
+{
+    /** Continuation processing the messages left over by the budget */
+    ev_idle idle;
+    /** Number of messages given to Lua */
+    unsigned long processed;
+    /** Number of messages dropped because nobody listens to them */
+    unsigned long dropped;
+    /** Number of times messages were left for a later iteration */
+    unsigned long deferred;
+    /** Set when the bus sent the Disconnected signal */
+    bool disconnected;
+} a_dbus_dispatch_t;
+
+/** A libdbus timeout, used for method call replies */
+typedef struct
+{
+    ev_timer timer;
+    DBusTimeout *timeout;
+    /** The dispatching state of the bus the timeout belongs to */
+    a_dbus_dispatch_t *dispatch;
+} a_dbus_timeout_t;
+
+static a_dbus_dispatch_t dbus_dispatch_ses, dbus_dispatch_sys;
+
+/** Maximum number of messages processed per bus and per main loop
+ * iteration */
+static int dbus_dispatch_budget = DBUS_DISPATCH_BUDGET;
+
 static signal_array_t dbus_signals;
 
+/** A member an interface handler is restricted to */
+typedef struct
+{
+    /** The hash of "interface.member" */
+    unsigned long id;
+    /** The hash of the interface */
+    unsigned long interface;
+} dbus_member_filter_t;
+
+static int
+a_dbus_member_filter_cmp(const void *a, const void *b)
+{
+    const dbus_member_filter_t *x = a, *y = b;
+    return x->id > y->id ? 1 : (x->id < y->id ? -1 : 0);
+}
+
+DO_BARRAY(dbus_member_filter_t, dbus_member_filter, DO_NOTHING, a_dbus_member_filter_cmp)
+
+/** The members wanted by the interface handlers connected with a member
+ * list. Interfaces without entry get all their messages. */
+static dbus_member_filter_array_t dbus_member_filters;
+
+static DBusHandlerResult a_dbus_filter(DBusConnection *, DBusMessage *, void *);
+
 /** Clean up the D-Bus connection data members
  * \param dbus_connection The D-Bus connection to clean up
  * \param dbusio The D-Bus event watcher
+ * \param dispatch The D-Bus dispatching state
  */
 static void
-a_dbus_cleanup_bus(DBusConnection *dbus_connection, ev_io *dbusio)
+a_dbus_cleanup_bus(DBusConnection *dbus_connection, ev_io *dbusio,
+                   a_dbus_dispatch_t *dispatch)
 {
     if(!dbus_connection)
         return;
 
+    ev_idle_stop(EV_DEFAULT_UC_ &dispatch->idle);
+    dbus_connection_remove_filter(dbus_connection, a_dbus_filter, dispatch);
+    dbus_connection_set_timeout_functions(dbus_connection, NULL, NULL, NULL, NULL, NULL);
+
     if(dbusio->fd >= 0)
     {
         ev_ref(EV_DEFAULT_UC);
@@ -63,6 +127,62 @@ a_dbus_cleanup_bus(DBusConnection *dbus_connection, ev_io *dbusio)
     dbus_connection_unref(dbus_connection);
 }
 
+/** Hash an interface and a member name as a_strhash() would hash
+ * "interface.member", without building the string.
+ * \param interface The interface hash.
+ * \param member The member name.
+ * \return The hash.
+ */
+static unsigned long
+a_dbus_member_hash(unsigned long interface, const char *member)
+{
+    unsigned long hash = interface * 33 + '.';
+    int c;
+
+    while((c = *member++))
+        hash = ((hash << 5) + hash) + c;
+
+    return hash;
+}
+
+/** Check if a message is wanted by the handler of its interface.
+ * \param interface The interface hash.
+ * \param member The member name.
+ * \return False if the handler restricted itself to other members.
+ */
+static bool
+a_dbus_member_wanted(unsigned long interface, const char *member)
+{
+    bool filtered = false;
+
+    if(!dbus_member_filters.len)
+        return true;
+
+    dbus_member_filter_t filter = { .id = a_dbus_member_hash(interface, NONULL(member)) };
+    if(dbus_member_filter_array_lookup(&dbus_member_filters, &filter))
+        return true;
+
+    foreach(f, dbus_member_filters)
+        if(f->interface == interface)
+        {
+            filtered = true;
+            break;
+        }
+
+    return !filtered;
+}
+
+/** Remove the member filters of an interface.
+ * \param interface The interface hash.
+ */
+static void
+a_dbus_member_filters_remove(unsigned long interface)
+{
+    for(int i = 0; i < dbus_member_filters.len; i++)
+        if(dbus_member_filters.tab[i].interface == interface)
+            dbus_member_filter_array_take(&dbus_member_filters, i--);
+}
+
 /** Iterate through the D-Bus messages counting each or traverse each sub message.
  * \param iter The D-Bus message iterator pointer
  * \return The number of arguments in the iterator
@@ -184,13 +304,33 @@ a_dbus_message_iter(DBusMessageIter *iter)
                     int n = a_dbus_message_iter(&subiter);
 
                     /* create a new table to store all the value */
-                    lua_createtable(globalconf.L, n, 0);
+                    lua_createtable(globalconf.L, 0, n);
                     /* move the table before array elements */
                     lua_insert(globalconf.L, - (n * 2) - 1);
 
                     for(int i = 0; i < n; i ++)
                         lua_rawset(globalconf.L, - (n * 2) - 1 + i * 2);
                 }
+                else if(array_type == DBUS_TYPE_STRING
+                        || array_type == DBUS_TYPE_OBJECT_PATH
+                        || array_type == DBUS_TYPE_SIGNATURE)
+                {
+                    DBusMessageIter subiter;
+                    dbus_message_iter_recurse(iter, &subiter);
+
+                    /* store the strings directly in the table instead of
+                     * pushing them all on the stack first */
+                    lua_newtable(globalconf.L);
+                    for(int i = 1;
+                        dbus_message_iter_get_arg_type(&subiter) != DBUS_TYPE_INVALID;
+                        i++, dbus_message_iter_next(&subiter))
+                    {
+                        const char *s;
+                        dbus_message_iter_get_basic(&subiter, &s);
+                        lua_pushstring(globalconf.L, s);
+                        lua_rawseti(globalconf.L, -2, i);
+                    }
+                }
                 else
                 {
                     DBusMessageIter subiter;
@@ -244,6 +384,8 @@ a_dbus_message_iter(DBusMessageIter *iter)
           DBUS_MSG_HANDLE_TYPE_NUMBER(uint64_t, DBUS_TYPE_UINT64)
 #undef DBUS_MSG_HANDLE_TYPE_NUMBER
           case DBUS_TYPE_STRING:
+          case DBUS_TYPE_OBJECT_PATH:
+          case DBUS_TYPE_SIGNATURE:
             {
                 char *s;
                 dbus_message_iter_get_basic(iter, &s);
@@ -343,13 +485,23 @@ a_dbus_convert_value(lua_State *L, int idx, DBusMessageIter *iter)
 /** Process a single request from D-Bus
  * \param dbus_connection  The connection to the D-Bus server.
  * \param msg The D-Bus message request being sent to the D-Bus connection.
+ * \return False if the message was dropped without reaching Lua.
  */
-static void
+static bool
 a_dbus_process_request(DBusConnection *dbus_connection, DBusMessage *msg)
 {
     const char *interface = dbus_message_get_interface(msg);
+    const char *member = dbus_message_get_member(msg);
+    unsigned long interface_id = a_strhash((const unsigned char *) NONULL(interface));
+    signal_t *sig = signal_array_getbyid(&dbus_signals, interface_id);
+
+    /* Drop the messages nobody listens to before doing any Lua work */
+    if(!sig || !sig->sigfuncs.len || !a_dbus_member_wanted(interface_id, member))
+        return false;
+
     int old_top = lua_gettop(globalconf.L);
 
+    /* A new table each time: handlers may add fields to it or keep it */
     lua_createtable(globalconf.L, 0, 5);
 
     switch(dbus_message_get_type(msg))
@@ -380,8 +532,7 @@ a_dbus_process_request(DBusConnection *dbus_connection, DBusMessage *msg)
     lua_pushstring(globalconf.L, s);
     lua_setfield(globalconf.L, -2, "path");
 
-    s = dbus_message_get_member(msg);
-    lua_pushstring(globalconf.L, s);
+    lua_pushstring(globalconf.L, member);
     lua_setfield(globalconf.L, -2, "member");
 
     if(dbus_connection == dbus_connection_system)
@@ -398,98 +549,123 @@ a_dbus_process_request(DBusConnection *dbus_connection, DBusMessage *msg)
         nargs += a_dbus_message_iter(&iter);
 
     if(dbus_message_get_no_reply(msg))
-    {
-        signal_t *sigfound = signal_array_getbyid(&dbus_signals,
-                                                  a_strhash((const unsigned char *) NONULL(interface)));
         /* emit signals */
-        if(sigfound)
-            signal_object_emit(globalconf.L, &dbus_signals, NONULL(interface), nargs);
-    }
+        signal_object_emit(globalconf.L, &dbus_signals, NONULL(interface), nargs);
     else
     {
-        signal_t *sig = signal_array_getbyid(&dbus_signals,
-                                             a_strhash((const unsigned char *) NONULL(interface)));
-        if(sig)
-        {
-            /* there can be only ONE handler to send reply */
-            void *func = (void *) sig->sigfuncs.tab[0];
+        /* there can be only ONE handler to send reply */
+        void *func = (void *) sig->sigfuncs.tab[0];
+
+        int n = lua_gettop(globalconf.L) - nargs;
 
-            int n = lua_gettop(globalconf.L) - nargs;
+        luaA_object_push(globalconf.L, (void *) func);
+        luaA_dofunction(globalconf.L, nargs, LUA_MULTRET);
 
-            luaA_object_push(globalconf.L, (void *) func);
-            luaA_dofunction(globalconf.L, nargs, LUA_MULTRET);
+        n -= lua_gettop(globalconf.L);
 
-            n -= lua_gettop(globalconf.L);
+        DBusMessage *reply = dbus_message_new_method_return(msg);
 
-            DBusMessage *reply = dbus_message_new_method_return(msg);
+        dbus_message_iter_init_append(reply, &iter);
 
-            dbus_message_iter_init_append(reply, &iter);
+        if(n % 2 != 0)
+        {
+            luaA_warn(globalconf.L,
+                      "your D-Bus signal handling method returned wrong number of arguments");
+            /* Restore stack */
+            lua_settop(globalconf.L, old_top);
+            return true;
+        }
 
-            if(n % 2 != 0)
+        /* i is negative */
+        for(int i = n; i < 0; i += 2)
+        {
+            if(!a_dbus_convert_value(globalconf.L, i, &iter))
             {
-                luaA_warn(globalconf.L,
-                          "your D-Bus signal handling method returned wrong number of arguments");
+                luaA_warn(globalconf.L, "your D-Bus signal handling method returned bad data");
                 /* Restore stack */
                 lua_settop(globalconf.L, old_top);
-                return;
+                return true;
             }
 
-            /* i is negative */
-            for(int i = n; i < 0; i += 2)
-            {
-                if(!a_dbus_convert_value(globalconf.L, i, &iter))
-                {
-                    luaA_warn(globalconf.L, "your D-Bus signal handling method returned bad data");
-                    /* Restore stack */
-                    lua_settop(globalconf.L, old_top);
-                    return;
-                }
-
-                lua_remove(globalconf.L, i);
-                lua_remove(globalconf.L, i + 1);
-            }
-
-            dbus_connection_send(dbus_connection, reply, NULL);
-            dbus_message_unref(reply);
+            lua_remove(globalconf.L, i);
+            lua_remove(globalconf.L, i + 1);
         }
+
+        dbus_connection_send(dbus_connection, reply, NULL);
+        dbus_message_unref(reply);
     }
     /* Restore stack */
     lua_settop(globalconf.L, old_top);
+    return true;
 }
 
-/** Attempt to process all the requests in the D-Bus connection.
+/** Handle a message dispatched by libdbus.
+ * Replies to method calls made with dbus.call() do not go through this
+ * filter: libdbus hands them to their pending call.
+ * \param dbus_connection The D-Bus connection.
+ * \param msg The message.
+ * \param data The D-Bus dispatching state.
+ * \return Always DBUS_HANDLER_RESULT_HANDLED.
+ */
+static DBusHandlerResult
+a_dbus_filter(DBusConnection *dbus_connection, DBusMessage *msg, void *data)
+{
+    a_dbus_dispatch_t *dispatch = data;
+
+    if(dbus_message_is_signal(msg, DBUS_INTERFACE_LOCAL, "Disconnected"))
+        dispatch->disconnected = true;
+    else if(a_dbus_process_request(dbus_connection, msg))
+        dispatch->processed++;
+    else
+        dispatch->dropped++;
+
+    return DBUS_HANDLER_RESULT_HANDLED;
+}
+
+/** Attempt to process the requests in the D-Bus connection.
+ * At most dbus_dispatch_budget messages are processed, so that a busy bus
+ * does not delay X events. The remaining messages are processed on the next
+ * main loop iterations by an idle watcher.
  * \param dbus_connection The D-Bus connection to process from
  * \param dbusio The D-Bus event watcher
+ * \param dispatch The D-Bus dispatching state
  */
 static void
-a_dbus_process_requests_on_bus(DBusConnection *dbus_connection, ev_io *dbusio)
+a_dbus_process_requests_on_bus(DBusConnection *dbus_connection, ev_io *dbusio,
+                               a_dbus_dispatch_t *dispatch)
 {
-    DBusMessage *msg;
     int nmsg = 0;
 
-    while(true)
+    while(nmsg < dbus_dispatch_budget)
     {
         dbus_connection_read_write(dbus_connection, 0);
 
-        if(!(msg = dbus_connection_pop_message(dbus_connection)))
+        if(dbus_connection_get_dispatch_status(dbus_connection) != DBUS_DISPATCH_DATA_REMAINS)
             break;
 
-        if(dbus_message_is_signal(msg, DBUS_INTERFACE_LOCAL, "Disconnected"))
+        dbus_connection_dispatch(dbus_connection);
+
+        if(dispatch->disconnected)
         {
-            a_dbus_cleanup_bus(dbus_connection, dbusio);
-            dbus_message_unref(msg);
+            a_dbus_cleanup_bus(dbus_connection, dbusio, dispatch);
             return;
         }
-        else
-            a_dbus_process_request(dbus_connection, msg);
-
-        dbus_message_unref(msg);
 
         nmsg++;
     }
 
     if(nmsg)
         dbus_connection_flush(dbus_connection);
+
+    /* Messages read from the socket do not wake the io watcher up again */
+    if(nmsg >= dbus_dispatch_budget
+       && dbus_connection_get_dispatch_status(dbus_connection) == DBUS_DISPATCH_DATA_REMAINS)
+    {
+        dispatch->deferred++;
+        ev_idle_start(EV_DEFAULT_UC_ &dispatch->idle);
+    }
+    else
+        ev_idle_stop(EV_DEFAULT_UC_ &dispatch->idle);
 }
 
 /** Foreword D-Bus process session requests on too the correct function.
@@ -499,7 +675,7 @@ a_dbus_process_requests_on_bus(DBusConnection *dbus_connection, ev_io *dbusio)
 static void
 a_dbus_process_requests_session(EV_P_ ev_io *w, int revents)
 {
-    a_dbus_process_requests_on_bus(dbus_connection_session, w);
+    a_dbus_process_requests_on_bus(dbus_connection_session, w, &dbus_dispatch_ses);
 }
 
 /** Foreword D-Bus process system requests on too the correct function.
@@ -509,7 +685,104 @@ a_dbus_process_requests_session(EV_P_ ev_io *w, int revents)
 static void
 a_dbus_process_requests_system(EV_P_ ev_io *w, int revents)
 {
-    a_dbus_process_requests_on_bus(dbus_connection_system, w);
+    a_dbus_process_requests_on_bus(dbus_connection_system, w, &dbus_dispatch_sys);
+}
+
+/** Continue processing the session requests left over by the budget.
+ * \param w The idle watcher
+ * \param revents (not used)
+ */
+static void
+a_dbus_process_leftover_session(EV_P_ ev_idle *w, int revents)
+{
+    a_dbus_process_requests_on_bus(dbus_connection_session, &dbusio_ses, &dbus_dispatch_ses);
+}
+
+/** Continue processing the system requests left over by the budget.
+ * \param w The idle watcher
+ * \param revents (not used)
+ */
+static void
+a_dbus_process_leftover_system(EV_P_ ev_idle *w, int revents)
+{
+    a_dbus_process_requests_on_bus(dbus_connection_system, &dbusio_sys, &dbus_dispatch_sys);
+}
+
+/** Handle a libdbus timeout.
+ * \param w The timer.
+ * \param revents (not used)
+ */
+static void
+a_dbus_timeout_cb(EV_P_ ev_timer *w, int revents)
+{
+    a_dbus_timeout_t *t = (a_dbus_timeout_t *) w;
+
+    dbus_timeout_handle(t->timeout);
+    /* The timeout queued an error reply, dispatch it */
+    ev_idle_start(EV_A_ &t->dispatch->idle);
+}
+
+/** Start the timer of a libdbus timeout if it is enabled.
+ * \param t The timeout.
+ */
+static void
+a_dbus_timeout_update(a_dbus_timeout_t *t)
+{
+    ev_timer_stop(EV_DEFAULT_UC_ &t->timer);
+    if(dbus_timeout_get_enabled(t->timeout))
+    {
+        double interval = dbus_timeout_get_interval(t->timeout) / 1000.;
+        ev_timer_set(&t->timer, interval, interval);
+        ev_timer_start(EV_DEFAULT_UC_ &t->timer);
+    }
+}
+
+/** Add a libdbus timeout to the main loop.
+ * \param timeout The timeout.
+ * \param data The D-Bus dispatching state.
+ * \return True.
+ */
+static dbus_bool_t
+a_dbus_add_timeout(DBusTimeout *timeout, void *data)
+{
+    a_dbus_timeout_t *t = p_new(a_dbus_timeout_t, 1);
+
+    ev_init(&t->timer, a_dbus_timeout_cb);
+    t->timeout = timeout;
+    t->dispatch = data;
+    dbus_timeout_set_data(timeout, t, NULL);
+    a_dbus_timeout_update(t);
+    return TRUE;
+}
+
+/** Remove a libdbus timeout from the main loop.
+ * \param timeout The timeout.
+ * \param data The D-Bus dispatching state.
+ */
+static void
+a_dbus_remove_timeout(DBusTimeout *timeout, void *data)
+{
+    a_dbus_timeout_t *t = dbus_timeout_get_data(timeout);
+
+    if(t)
+    {
+        ev_timer_stop(EV_DEFAULT_UC_ &t->timer);
+        dbus_timeout_set_data(timeout, NULL, NULL);
+        p_delete(&t);
+    }
+}
+
+/** Enable or disable a libdbus timeout.
+ * \param timeout The timeout.
+ * \param data The D-Bus dispatching state.
+ */
+static void
+a_dbus_toggle_timeout(DBusTimeout *timeout, void *data)
+{
+    a_dbus_timeout_t *t = dbus_timeout_get_data(timeout);
+
+    if(t)
+        a_dbus_timeout_update(t);
 }
 
 /** Attempt to request a D-Bus name
@@ -590,11 +863,14 @@ a_dbus_release_name(DBusConnection *dbus_connection, const char *name)
  * \param type_name The bus type name eg: "session" or "system"
  * \param dbusio The D-Bus event watcher
  * \param cb Function callback to use when processing requests
+ * \param dispatch The D-Bus dispatching state
+ * \param idle_cb Function callback to use when processing leftover requests
  * \return The requested D-Bus connection on success, NULL on failure.
  */
 static DBusConnection *
 a_dbus_connect(DBusBusType type, const char *type_name,
-               ev_io *dbusio, void *cb)
+               ev_io *dbusio, void *cb,
+               a_dbus_dispatch_t *dispatch, void *idle_cb)
 {
     int fd;
     DBusConnection *dbus_connection;
@@ -612,6 +888,11 @@ a_dbus_connect(DBusBusType type, const char *type_name,
     else
     {
         dbus_connection_set_exit_on_disconnect(dbus_connection, false);
+        ev_idle_init(&dispatch->idle, idle_cb);
+        dbus_connection_add_filter(dbus_connection, a_dbus_filter, dispatch, NULL);
+        dbus_connection_set_timeout_functions(dbus_connection, a_dbus_add_timeout,
+                                              a_dbus_remove_timeout, a_dbus_toggle_timeout,
+                                              dispatch, NULL);
         if(dbus_connection_get_unix_fd(dbus_connection, &fd))
         {
             fcntl(fd, F_SETFD, FD_CLOEXEC);
@@ -623,7 +904,7 @@ a_dbus_connect(DBusBusType type, const char *type_name,
         else
         {
             warn("cannot get D-Bus connection file descriptor");
-            a_dbus_cleanup_bus(dbus_connection, dbusio);
+            a_dbus_cleanup_bus(dbus_connection, dbusio, dispatch);
         }
     }
 
@@ -636,9 +917,11 @@ void
 a_dbus_init(void)
 {
     dbus_connection_session = a_dbus_connect(DBUS_BUS_SESSION, "session",
-                                             &dbusio_ses, a_dbus_process_requests_session);
+                                             &dbusio_ses, a_dbus_process_requests_session,
+                                             &dbus_dispatch_ses, a_dbus_process_leftover_session);
     dbus_connection_system = a_dbus_connect(DBUS_BUS_SYSTEM, "system",
-                                            &dbusio_sys, a_dbus_process_requests_system);
+                                            &dbusio_sys, a_dbus_process_requests_system,
+                                            &dbus_dispatch_sys, a_dbus_process_leftover_system);
 }
 
 /** Cleanup the D-Bus session and system
@@ -646,8 +929,8 @@ a_dbus_init(void)
 void
 a_dbus_cleanup(void)
 {
-    a_dbus_cleanup_bus(dbus_connection_session, &dbusio_ses);
-    a_dbus_cleanup_bus(dbus_connection_system, &dbusio_sys);
+    a_dbus_cleanup_bus(dbus_connection_session, &dbusio_ses, &dbus_dispatch_ses);
+    a_dbus_cleanup_bus(dbus_connection_system, &dbusio_sys, &dbus_dispatch_sys);
 }
 
 /** Retrieve the D-Bus bus by it's name
@@ -753,18 +1036,42 @@ luaA_dbus_remove_match(lua_State *L)
  * \luastack
  * \lparam A string with the interface name.
  * \lparam The function to call.
+ * \lparam An optional table of member names. Messages for other members of
+ * the interface are dropped without calling the function.
  */
 static int
 luaA_dbus_connect_signal(lua_State *L)
 {
     const char *name = luaL_checkstring(L, 1);
     luaA_checkfunction(L, 2);
-    signal_t *sig = signal_array_getbyid(&dbus_signals,
-                                         a_strhash((const unsigned char *) name));
+    unsigned long id = a_strhash((const unsigned char *) name);
+    signal_t *sig = signal_array_getbyid(&dbus_signals, id);
     if(sig)
         luaA_warn(L, "cannot add signal %s on D-Bus, already existing", name);
     else
     {
+        if(!lua_isnoneornil(L, 3))
+        {
+            luaA_checktable(L, 3);
+            /* Check all the members before adding any filter */
+            for(int i = 1; i <= luaA_rawlen(L, 3); i++)
+            {
+                lua_rawgeti(L, 3, i);
+                luaL_argcheck(L, lua_type(L, -1) == LUA_TSTRING, 3, "member names must be strings");
+                lua_pop(L, 1);
+            }
+            for(int i = 1; i <= luaA_rawlen(L, 3); i++)
+            {
+                lua_rawgeti(L, 3, i);
+                dbus_member_filter_t filter =
+                {
+                    .id = a_dbus_member_hash(id, luaL_checkstring(L, -1)),
+                    .interface = id
+                };
+                dbus_member_filter_array_insert(&dbus_member_filters, filter);
+                lua_pop(L, 1);
+            }
+        }
         signal_add(&dbus_signals, name);
         signal_connect(&dbus_signals, name, luaA_object_ref(L, 2));
     }
@@ -785,10 +1092,210 @@ luaA_dbus_disconnect_signal(lua_State *L)
     luaA_checkfunction(L, 2);
     const void *func = lua_topointer(L, 2);
     signal_disconnect(&dbus_signals, name, func);
+    a_dbus_member_filters_remove(a_strhash((const unsigned char *) name));
     luaA_object_unref(L, (void *) func);
     return 0;
 }
 
+/** Deliver the reply of a method call to its Lua callback.
+ * \param pending The pending call.
+ * \param data The reference of the Lua callback.
+ */
+static void
+a_dbus_call_notify(DBusPendingCall *pending, void *data)
+{
+    int *ref = data;
+    DBusMessage *reply = dbus_pending_call_steal_reply(pending);
+    int nargs = 1;
+
+    if(!reply)
+        return;
+
+    if(dbus_message_get_type(reply) == DBUS_MESSAGE_TYPE_ERROR)
+    {
+        DBusError err;
+
+        dbus_error_init(&err);
+        dbus_set_error_from_message(&err, reply);
+        lua_pushboolean(globalconf.L, false);
+        lua_pushstring(globalconf.L, err.name);
+        lua_pushstring(globalconf.L, err.message);
+        nargs += 2;
+        dbus_error_free(&err);
+    }
+    else
+    {
+        DBusMessageIter iter;
+
+        lua_pushboolean(globalconf.L, true);
+        if(dbus_message_iter_init(reply, &iter))
+            nargs += a_dbus_message_iter(&iter);
+    }
+
+    luaA_dofunction_from_registry(globalconf.L, *ref, nargs, 0);
+    dbus_message_unref(reply);
+}
+
+/** Release the Lua callback of a method call.
+ * \param data The reference of the Lua callback.
+ */
+static void
+a_dbus_call_free(void *data)
+{
+    int *ref = data;
+    luaA_unregister(globalconf.L, ref);
+    p_delete(&ref);
+}
+
+/** Call a D-Bus method without waiting for its reply.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam A string indicating if we are using system or session bus.
+ * \lparam The destination name.
+ * \lparam The object path.
+ * \lparam The interface name.
+ * \lparam The method name.
+ * \lparam A table of arguments, as a list of type and value pairs, or nil.
+ * \lparam An optional function called with true and the reply arguments, or
+ * false, the error name and the error message.
+ * \lparam An optional timeout in seconds.
+ * \lreturn True if the call was sent, nil and an error string otherwise.
+ */
+static int
+luaA_dbus_call(lua_State *L)
+{
+    const char *bus = luaL_checkstring(L, 1);
+    const char *dest = luaL_checkstring(L, 2);
+    const char *path = luaL_checkstring(L, 3);
+    const char *iface = luaL_checkstring(L, 4);
+    const char *method = luaL_checkstring(L, 5);
+    bool has_callback = !lua_isnoneornil(L, 7);
+    int timeout = lua_isnoneornil(L, 8) ? -1 : luaL_checknumber(L, 8) * 1000;
+    DBusConnection *dbus_connection = a_dbus_bus_getbyname(bus);
+    DBusPendingCall *pending = NULL;
+    DBusMessageIter iter;
+    DBusMessage *msg;
+
+    if(!lua_isnoneornil(L, 6))
+        luaA_checktable(L, 6);
+    if(has_callback)
+        luaA_checkfunction(L, 7);
+
+    if(!dbus_connection)
+    {
+        lua_pushnil(L);
+        lua_pushfstring(L, "no D-Bus %s bus", bus);
+        return 2;
+    }
+
+    if(!(msg = dbus_message_new_method_call(dest, path, iface, method)))
+    {
+        lua_pushnil(L);
+        lua_pushliteral(L, "cannot create D-Bus method call");
+        return 2;
+    }
+
+    dbus_message_iter_init_append(msg, &iter);
+
+    if(!lua_isnoneornil(L, 6))
+    {
+        int argslen = luaA_rawlen(L, 6);
+
+        for(int i = 1; i < argslen; i += 2)
+        {
+            lua_rawgeti(L, 6, i);
+            lua_rawgeti(L, 6, i + 1);
+            if(!a_dbus_convert_value(L, -2, &iter))
+            {
+                dbus_message_unref(msg);
+                lua_pushnil(L);
+                lua_pushliteral(L, "bad D-Bus method call arguments");
+                return 2;
+            }
+            lua_pop(L, 2);
+        }
+    }
+
+    if(!has_callback)
+    {
+        dbus_message_set_no_reply(msg, true);
+        dbus_connection_send(dbus_connection, msg, NULL);
+    }
+    else if(!dbus_connection_send_with_reply(dbus_connection, msg, &pending, timeout)
+            || !pending)
+    {
+        dbus_message_unref(msg);
+        lua_pushnil(L);
+        lua_pushliteral(L, "cannot send D-Bus method call");
+        return 2;
+    }
+    else
+    {
+        int *ref = p_new(int, 1);
+        *ref = LUA_REFNIL;
+        luaA_registerfct(L, 7, ref);
+        dbus_pending_call_set_notify(pending, a_dbus_call_notify, ref, a_dbus_call_free);
+        dbus_pending_call_unref(pending);
+    }
+
+    dbus_message_unref(msg);
+    dbus_connection_flush(dbus_connection);
+
+    lua_pushboolean(L, true);
+    return 1;
+}
+
+/** Set the number of messages processed per bus and per main loop
+ * iteration.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam The number of messages, or nil for the default.
+ */
+static int
+luaA_dbus_set_budget(lua_State *L)
+{
+    if(lua_isnoneornil(L, 1))
+        dbus_dispatch_budget = DBUS_DISPATCH_BUDGET;
+    else
+        dbus_dispatch_budget = MAX(luaL_checknumber(L, 1), 1);
+    return 0;
+}
+
+/** Push the dispatching counters of a bus.
+ * \param L The Lua VM state.
+ * \param dispatch The D-Bus dispatching state.
+ */
+static void
+luaA_dbus_push_dispatch(lua_State *L, a_dbus_dispatch_t *dispatch)
+{
+    lua_createtable(L, 0, 3);
+    lua_pushnumber(L, dispatch->processed);
+    lua_setfield(L, -2, "processed");
+    lua_pushnumber(L, dispatch->dropped);
+    lua_setfield(L, -2, "dropped");
+    lua_pushnumber(L, dispatch->deferred);
+    lua_setfield(L, -2, "deferred");
+}
+
+/** Get the message counters of the buses.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lreturn A table with the session and system counters.
+ */
+static int
+luaA_dbus_get_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 2);
+    luaA_dbus_push_dispatch(L, &dbus_dispatch_ses);
+    lua_setfield(L, -2, "session");
+    luaA_dbus_push_dispatch(L, &dbus_dispatch_sys);
+    lua_setfield(L, -2, "system");
+    return 1;
+}
+
 const struct luaL_Reg awesome_dbus_lib[] =
 {
     { "request_name", luaA_dbus_request_name },
@@ -797,6 +1304,9 @@ const struct luaL_Reg awesome_dbus_lib[] =
     { "remove_match", luaA_dbus_remove_match },
     { "connect_signal", luaA_dbus_connect_signal },
     { "disconnect_signal", luaA_dbus_disconnect_signal },
+    { "call", luaA_dbus_call },
+    { "set_budget", luaA_dbus_set_budget },
+    { "get_stats", luaA_dbus_get_stats },
     { NULL, NULL }
 };
 
@@ -395,6 +395,38 @@ event_handle_motionnotify(xcb_motion_notify_event_t *ev)
     }
 }
 
+/** Forget about ignored request ranges the server is done with.
+ * \param sequence The sequence number of the event being handled.
+ */
+static void
+event_prune_ignored_ranges(uint32_t sequence)
+{
+    sequence_pair_array_t *ranges = &globalconf.ignore_enter_leave_events;
+    int done = 0;
+
+    /* Sequence numbers wrap around, so compare their difference */
+    while(done < ranges->len && (int32_t) (sequence - ranges->tab[done].end) >= 0)
+        done++;
+
+    if(done > 0)
+        sequence_pair_array_splice(ranges, 0, done, NULL, 0);
+}
+
+/** Check whether an enter or leave event was caused by a request sent while
+ * client_ignore_enterleave_events() was active.
+ * \param ev The event.
+ * \return True if the event must be ignored.
+ */
+static bool
+event_enterleave_ignored(xcb_generic_event_t *ev)
+{
+    foreach(range, globalconf.ignore_enter_leave_events)
+        if((int32_t) (ev->full_sequence - range->begin) > 0
+           && (int32_t) (ev->full_sequence - range->end) < 0)
+            return true;
+    return false;
+}
+
 /** The leave notify event handler.
  * \param ev The event.
  */
@@ -409,7 +441,8 @@ event_handle_leavenotify(xcb_leave_notify_event_t *ev)
     if(ev->mode != XCB_NOTIFY_MODE_NORMAL)
         return;
 
-    if((c = client_getbyframewin(ev->event)))
+    if((c = client_getbyframewin(ev->event))
+       && !event_enterleave_ignored((xcb_generic_event_t *) ev))
     {
         luaA_object_push(globalconf.L, c);
         luaA_object_emit_signal(globalconf.L, -1, "mouse::leave", 0);
@@ -445,7 +478,8 @@ event_handle_enternotify(xcb_enter_notify_event_t *ev)
         lua_pop(globalconf.L, 1);
     }
 
-    if((c = client_getbyframewin(ev->event)))
+    if((c = client_getbyframewin(ev->event))
+       && !event_enterleave_ignored((xcb_generic_event_t *) ev))
     {
         luaA_object_push(globalconf.L, c);
         luaA_object_emit_signal(globalconf.L, -1, "mouse::enter", 0);
@@ -546,6 +580,7 @@ static void
 event_handle_maprequest(xcb_map_request_event_t *ev)
 {
     client_t *c;
+    xembed_window_t *em;
     xcb_get_window_attributes_cookie_t wa_c;
     xcb_get_window_attributes_reply_t *wa_r;
     xcb_get_geometry_cookie_t geom_c;
@@ -559,9 +594,10 @@ event_handle_maprequest(xcb_map_request_event_t *ev)
     if(wa_r->override_redirect)
         goto bailout;
 
-    if(xembed_getbywin(&globalconf.embedded, ev->window))
+    if((em = xembed_getbywin(&globalconf.embedded, ev->window)))
     {
         xcb_map_window(globalconf.connection, ev->window);
+        em->mapped = true;
         xembed_window_activate(globalconf.connection, ev->window);
     }
     else if((c = client_getbywin(ev->window)))
@@ -751,6 +787,9 @@ void event_handle(xcb_generic_event_t *event)
 {
     uint8_t response_type = XCB_EVENT_RESPONSE_TYPE(event);
 
+    if(globalconf.ignore_enter_leave_events.len > 0)
+        event_prune_ignored_ranges(event->full_sequence);
+
     if(response_type == 0)
     {
         /* This is an error, not a event */
@@ -23,6 +23,8 @@
 #define AWESOME_EVENT_H
 
 #include "objects/client.h"
+#include "profiler.h"
+#include "xtrace.h"
 
 /* luaa.c */
 void luaA_emit_refresh(void);
@@ -30,11 +32,22 @@ void luaA_emit_refresh(void);
 static inline int
 awesome_refresh(void)
 {
+    int ret;
+    const char *phase = xtrace_enter("refresh");
+
+    profiler_begin();
     luaA_emit_refresh();
+    profiler_mark(PROFILER_PHASE_LUA_REFRESH);
     banning_refresh();
+    profiler_mark(PROFILER_PHASE_BANNING);
     stack_refresh();
+    profiler_mark(PROFILER_PHASE_STACK);
     client_focus_refresh();
-    return xcb_flush(globalconf.connection);
+    profiler_mark(PROFILER_PHASE_FOCUS);
+    ret = xcb_flush(globalconf.connection);
+    profiler_mark(PROFILER_PHASE_FLUSH);
+    xtrace_leave(phase);
+    return ret;
 }
 
 void event_handle(xcb_generic_event_t *event);
@@ -0,0 +1,348 @@
+/*
+ * fswatch.c - directory scanning and watching
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "config.h"
+#ifdef HAS_INOTIFY
+#include <sys/inotify.h>
+#endif
+
+#include "fswatch.h"
+#include "globalconf.h"
+#include "luaa.h"
+#include "common/buffer.h"
+
+#ifdef HAS_INOTIFY
+
+/** A watched directory */
+typedef struct
+{
+    /** The inotify watch descriptor */
+    int wd;
+    /** The path given to watchdir() */
+    char *path;
+    /** The Lua function to call on changes */
+    int callback;
+} fswatch_t;
+
+DO_ARRAY(fswatch_t, fswatch, DO_NOTHING)
+
+/** The inotify instance, created on first use */
+static struct
+{
+    int fd;
+    ev_io io;
+    fswatch_array_t watches;
+} fswatch_inotify = { .fd = -1 };
+
+/** Check if a watch calls a function.
+ * \param L The Lua VM state.
+ * \param watch The watch.
+ * \param idx The index of the function on the stack.
+ * \return True if the watch callback is this function.
+ */
+static bool
+fswatch_calls(lua_State *L, fswatch_t *watch, int idx)
+{
+    lua_rawgeti(L, LUA_REGISTRYINDEX, watch->callback);
+    bool ret = lua_rawequal(L, -1, idx < 0 ? idx - 1 : idx);
+    lua_pop(L, 1);
+    return ret;
+}
+
+/** Forget a watch, and stop watching its directory if it was the last one.
+ * \param L The Lua VM state.
+ * \param i The index of the watch.
+ * \param rm True if the inotify watch still exists and must be removed.
+ */
+static void
+fswatch_remove(lua_State *L, int i, bool rm)
+{
+    fswatch_t *watch = &fswatch_inotify.watches.tab[i];
+    int wd = watch->wd;
+
+    luaA_unregister(L, &watch->callback);
+    p_delete(&watch->path);
+    fswatch_array_take(&fswatch_inotify.watches, i);
+
+    if(!rm)
+        return;
+
+    foreach(w, fswatch_inotify.watches)
+        if(w->wd == wd)
+            return;
+
+    inotify_rm_watch(fswatch_inotify.fd, wd);
+}
+
+/** Call the Lua callbacks of a watch descriptor.
+ * \param L The Lua VM state.
+ * \param wd The watch descriptor.
+ * \param name The changed file name, or NULL for the directory itself.
+ * \param removed True if the directory is not watched anymore.
+ */
+static void
+fswatch_dispatch(lua_State *L, int wd, const char *name, bool removed)
+{
+    /* The callbacks may watch or unwatch directories, which moves or
+     * shrinks the array: index it again after each call. */
+    for(int i = 0; i < fswatch_inotify.watches.len; i++)
+    {
+        int callback = fswatch_inotify.watches.tab[i].callback;
+
+        if(fswatch_inotify.watches.tab[i].wd != wd)
+            continue;
+
+        if(name)
+            lua_pushstring(L, name);
+        else
+            lua_pushnil(L);
+        lua_pushboolean(L, removed);
+        luaA_dofunction_from_registry(L, callback, 2, 0);
+
+        /* The watch unwatched itself, the next one took its place */
+        if(i >= fswatch_inotify.watches.len
+           || fswatch_inotify.watches.tab[i].callback != callback)
+            i--;
+    }
+
+    if(removed)
+        for(int i = 0; i < fswatch_inotify.watches.len;)
+            if(fswatch_inotify.watches.tab[i].wd == wd)
+                fswatch_remove(L, i, false);
+            else
+                i++;
+}
+
+/** Dispatch the inotify events to the Lua callbacks.
+ * \param loop The event loop.
+ * \param w The io watcher.
+ * \param revents The events.
+ */
+static void
+fswatch_inotify_cb(struct ev_loop *loop, ev_io *w, int revents)
+{
+    char events[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+    ssize_t len;
+
+    while((len = read(w->fd, events, sizeof(events))) > 0)
+        for(char *p = events; p < events + len;)
+        {
+            const struct inotify_event *event = (const struct inotify_event *) p;
+
+            /* The kernel dropped the watch: the directory was deleted,
+             * unmounted, or unwatched. */
+            if(event->mask & IN_IGNORED)
+                fswatch_dispatch(globalconf.L, event->wd, NULL, true);
+            else if(event->wd >= 0)
+                fswatch_dispatch(globalconf.L, event->wd,
+                                 event->len ? event->name : NULL, false);
+
+            p += sizeof(struct inotify_event) + event->len;
+        }
+}
+
+#endif
+
+/** List the files of a directory with their modification time.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam The directory path.
+ * \lparam An optional suffix the file names must end with.
+ * \lparam If true, hidden files and directories are listed too, directories
+ * with a trailing slash.
+ * \lparam If true, only the regular files the user can execute are listed.
+ * \lreturn A table mapping file names to their modification time and the
+ * modification time of the directory, or nil and an error string.
+ */
+int
+luaA_scandir(lua_State *L)
+{
+    const char *path = luaL_checkstring(L, 1);
+    size_t suffix_len = 0;
+    const char *suffix = luaL_optlstring(L, 2, NULL, &suffix_len);
+    bool all = luaA_optboolean(L, 3, false);
+    bool executable = luaA_optboolean(L, 4, false);
+    struct stat st;
+    struct dirent *entry;
+    buffer_t file;
+    DIR *dir;
+
+    if(!(dir = opendir(path)) || fstat(dirfd(dir), &st))
+    {
+        lua_pushnil(L);
+        lua_pushstring(L, strerror(errno));
+        if(dir)
+            closedir(dir);
+        return 2;
+    }
+
+    lua_newtable(L);
+    buffer_init(&file);
+
+    while((entry = readdir(dir)))
+    {
+        size_t len = a_strlen(entry->d_name);
+        struct stat fst;
+
+        if(entry->d_name[0] == '.'
+           && (!all || A_STREQ(entry->d_name, ".") || A_STREQ(entry->d_name, "..")))
+            continue;
+        if(suffix && (len < suffix_len || a_strcmp(entry->d_name + len - suffix_len, suffix)))
+            continue;
+
+        buffer_splice(&file, 0, file.len, NULL, 0);
+        buffer_addf(&file, "%s/%s", path, entry->d_name);
+        if(stat(file.s, &fst))
+            continue;
+
+        if(executable && (!S_ISREG(fst.st_mode) || access(file.s, X_OK)))
+            continue;
+
+        if(S_ISDIR(fst.st_mode) && all)
+            lua_pushfstring(L, "%s/", entry->d_name);
+        else if(S_ISREG(fst.st_mode))
+            lua_pushstring(L, entry->d_name);
+        else
+            continue;
+
+        lua_pushnumber(L, fst.st_mtime);
+        lua_rawset(L, -3);
+    }
+
+    buffer_wipe(&file);
+    closedir(dir);
+
+    lua_pushnumber(L, st.st_mtime);
+    return 2;
+}
+
+/** Watch a directory for changes.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam The directory path.
+ * \lparam A function called with the name of the changed file, or nil if the
+ * directory itself changed, and true if the directory is not watched anymore,
+ * for example because it was deleted.
+ * \lreturn True if the directory is watched, or false and an error string.
+ */
+int
+luaA_watchdir(lua_State *L)
+{
+    luaL_checkstring(L, 1);
+    luaA_checkfunction(L, 2);
+
+#ifdef HAS_INOTIFY
+    const char *path = lua_tostring(L, 1);
+
+    if(fswatch_inotify.fd < 0)
+    {
+        if((fswatch_inotify.fd = inotify_init()) < 0)
+            goto error;
+        fcntl(fswatch_inotify.fd, F_SETFD, FD_CLOEXEC);
+        fcntl(fswatch_inotify.fd, F_SETFL, O_NONBLOCK);
+        ev_io_init(&fswatch_inotify.io, fswatch_inotify_cb, fswatch_inotify.fd, EV_READ);
+        ev_io_start(globalconf.loop, &fswatch_inotify.io);
+    }
+
+    fswatch_t watch = { .callback = LUA_REFNIL };
+
+    watch.wd = inotify_add_watch(fswatch_inotify.fd, path,
+                                 IN_CLOSE_WRITE | IN_CREATE | IN_DELETE
+                                 | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB
+                                 | IN_DELETE_SELF | IN_MOVE_SELF);
+    if(watch.wd < 0)
+        goto error;
+
+    /* The same directory gives the same watch descriptor */
+    foreach(w, fswatch_inotify.watches)
+        if(w->wd == watch.wd && fswatch_calls(L, w, 2))
+        {
+            lua_pushboolean(L, true);
+            return 1;
+        }
+
+    watch.path = a_strdup(path);
+    luaA_registerfct(L, 2, &watch.callback);
+    fswatch_array_append(&fswatch_inotify.watches, watch);
+
+    lua_pushboolean(L, true);
+    return 1;
+
+error:
+    lua_pushboolean(L, false);
+    lua_pushstring(L, strerror(errno));
+    return 2;
+#else
+    lua_pushboolean(L, false);
+    lua_pushliteral(L, "directory watching is not supported");
+    return 2;
+#endif
+}
+
+/** Stop watching a directory.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam The directory path, as given to watchdir().
+ * \lparam An optional function: only this callback is removed, otherwise all
+ * the callbacks of the directory are.
+ * \lreturn True if a callback was removed.
+ */
+int
+luaA_unwatchdir(lua_State *L)
+{
+    bool all = lua_isnoneornil(L, 2);
+    bool removed = false;
+
+    luaL_checkstring(L, 1);
+    if(!all)
+        luaA_checkfunction(L, 2);
+
+#ifdef HAS_INOTIFY
+    const char *path = lua_tostring(L, 1);
+
+    for(int i = 0; i < fswatch_inotify.watches.len;)
+    {
+        fswatch_t *watch = &fswatch_inotify.watches.tab[i];
+
+        if(A_STREQ(watch->path, path) && (all || fswatch_calls(L, watch, 2)))
+        {
+            fswatch_remove(L, i, true);
+            removed = true;
+        }
+        else
+            i++;
+    }
+#endif
+
+    lua_pushboolean(L, removed);
+    return 1;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
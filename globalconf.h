@@ -60,6 +60,13 @@ ARRAY_TYPE(screen_t, screen)
 ARRAY_TYPE(client_t *, client)
 ARRAY_TYPE(drawin_t *, drawin)
 
+/** A range of X request sequence numbers */
+typedef struct
+{
+    uint32_t begin, end;
+} sequence_pair_t;
+DO_ARRAY(sequence_pair_t, sequence_pair, DO_NOTHING)
+
 /** Main configuration structure */
 typedef struct
 {
@@ -117,6 +124,14 @@ typedef struct
         xcb_window_t window;
         /** Systray window parent */
         drawin_t *parent;
+        /** Last geometry configured */
+        int16_t x, y;
+        uint16_t width, height;
+        /** Last background pixel set */
+        uint32_t background;
+        bool has_background;
+        /** Whether the window is mapped */
+        bool mapped;
     } systray;
     /** The monitor of startup notifications */
     SnMonitorContext *snmonitor;
@@ -134,6 +149,12 @@ typedef struct
     xcb_colormap_t default_cmap;
     /** Do we have to reban clients? */
     bool need_lazy_banning;
+    /** Request ranges whose enter/leave events on clients are ignored */
+    sequence_pair_array_t ignore_enter_leave_events;
+    /** Start of the range currently being recorded */
+    uint32_t pending_enter_leave_begin;
+    /** Nesting depth of client_ignore_enterleave_events() calls */
+    int pending_enter_leave_depth;
 } awesome_t;
 
 extern awesome_t globalconf;
@@ -36,6 +36,10 @@
 #include "ewmh.h"
 #include "luaa.h"
 #include "spawn.h"
+#include "fswatch.h"
+#include "luagc.h"
+#include "luacache.h"
+#include "restart.h"
 #include "objects/tag.h"
 #include "objects/client.h"
 #include "objects/drawin.h"
@@ -51,6 +55,7 @@
 extern const struct luaL_Reg awesome_dbus_lib[];
 #endif
 extern const struct luaL_Reg awesome_keygrabber_lib[];
+extern const struct luaL_Reg awesome_profiler_lib[];
 extern const struct luaL_Reg awesome_mousegrabber_lib[];
 extern const struct luaL_Reg awesome_root_lib[];
 extern const struct luaL_Reg awesome_mouse_methods[];
@@ -185,6 +190,7 @@ luaA_next(lua_State *L, int idx)
     return 0;
 }
 
+#ifndef WITH_LUAJIT
 /** Generic pairs function.
  * \param L The Lua VM state.
  * \return The number of elements pushed on stack.
@@ -246,6 +252,7 @@ luaAe_ipairs(lua_State *L)
     lua_pushinteger(L, 0);  /* and initial value */
     return 3;
 }
+#endif
 
 /** Enhanced type() function which recognize awesome objects.
  * \param L The Lua VM state.
@@ -259,6 +266,39 @@ luaAe_type(lua_State *L)
     return 1;
 }
 
+#ifdef WITH_LUAJIT
+/** pairs() and ipairs() for LuaJIT. The C versions above behave the same, but
+ * LuaJIT cannot compile a loop calling a C function for every step, while it
+ * compiles loops over the builtin next and ipairs. These are written in Lua
+ * and only fall back to the slow path for tables with metamethods. The chunk
+ * gets our next(), which honours __next, as argument.
+ */
+static const char luaA_luajit_iterators[] =
+    "local next = ...\n"
+    "local rawnext, rawipairs, rawget, type, error = _G.next, _G.ipairs, rawget, type, error\n"
+    "local getmetatable = debug.getmetatable\n"
+    "local function check(t, name)\n"
+    "    if type(t) ~= 'table' then\n"
+    "        error(\"bad argument #1 to '\" .. name .. \"' (table expected, got \" .. type(t) .. \")\", 3)\n"
+    "    end\n"
+    "end\n"
+    "function pairs(t, ...)\n"
+    "    local mt = getmetatable(t)\n"
+    "    local meta = mt and rawget(mt, '__pairs')\n"
+    "    if meta then return meta(t, ...) end\n"
+    "    check(t, 'pairs')\n"
+    "    if mt and rawget(mt, '__next') then return next, t, nil end\n"
+    "    return rawnext, t, nil\n"
+    "end\n"
+    "function ipairs(t, ...)\n"
+    "    local mt = getmetatable(t)\n"
+    "    local meta = mt and rawget(mt, '__ipairs')\n"
+    "    if meta then return meta(t, ...) end\n"
+    "    check(t, 'ipairs')\n"
+    "    return rawipairs(t)\n"
+    "end\n";
+#endif
+
 /** Replace various standards Lua functions with our own.
  * \param L The Lua VM state.
  */
@@ -270,9 +310,13 @@ luaA_fixups(lua_State *L)
     lua_pushcfunction(L, luaA_mbstrlen);
     lua_setfield(L, -2, "wlen");
     lua_pop(L, 1);
-    /* replace next */
+#ifdef WITH_LUAJIT
+    /* replace pairs and ipairs, before next is replaced */
+    if(luaL_loadstring(L, luaA_luajit_iterators))
+        fatal("cannot load the LuaJIT iterators: %s", lua_tostring(L, -1));
     lua_pushcfunction(L, luaAe_next);
-    lua_setglobal(L, "next");
+    lua_call(L, 1, 0);
+#else
     /* replace pairs */
     lua_pushcfunction(L, luaAe_next);
     lua_pushcclosure(L, luaAe_pairs, 1); /* pairs get next as upvalue */
@@ -281,6 +325,10 @@ luaA_fixups(lua_State *L)
     lua_pushcfunction(L, luaA_ipairs_aux);
     lua_pushcclosure(L, luaAe_ipairs, 1);
     lua_setglobal(L, "ipairs");
+#endif
+    /* replace next */
+    lua_pushcfunction(L, luaAe_next);
+    lua_setglobal(L, "next");
     /* replace type */
     lua_pushcfunction(L, luaAe_type);
     lua_setglobal(L, "type");
@@ -527,6 +575,11 @@ luaA_init(xdgHandle* xdg)
         { "emit_signal", luaA_awesome_emit_signal },
         { "systray", luaA_systray },
         { "load_image", luaA_load_image },
+        { "scandir", luaA_scandir },
+        { "watchdir", luaA_watchdir },
+        { "unwatchdir", luaA_unwatchdir },
+        { "gc", luaA_gc },
+        { "restart_state", luaA_restart_state },
         { "__index", luaA_awesome_index },
         { NULL, NULL }
     };
@@ -548,6 +601,13 @@ luaA_init(xdgHandle* xdg)
     /* Export awesome lib */
     luaA_openlib(L, "awesome", awesome_lib, awesome_lib);
 
+    /* Export profiler lib as awesome.profiler */
+    lua_getglobal(L, "awesome");
+    lua_newtable(L);
+    luaA_registerlib(L, NULL, awesome_profiler_lib);
+    lua_setfield(L, -2, "profiler");
+    lua_pop(L, 1);
+
     /* Export root lib */
     luaA_registerlib(L, "root", awesome_root_lib);
     lua_pop(L, 1); /* luaA_registerlib() leaves the table on stack */
@@ -636,6 +696,9 @@ luaA_init(xdgHandle* xdg)
 
     lua_pop(L, 2); /* pop "package" and "package.loaded" */
 
+    /* load Lua files through the bytecode cache */
+    luacache_init(L, xdg);
+
     signal_add(&global_signals, "debug::error");
     signal_add(&global_signals, "debug::deprecation");
     signal_add(&global_signals, "debug::index::miss");
@@ -657,7 +720,7 @@ luaA_startup_error(const char *err)
 static bool
 luaA_loadrc(const char *confpath, bool run)
 {
-    if(!luaL_loadfile(globalconf.L, confpath))
+    if(!luacache_loadfile(globalconf.L, confpath))
     {
         if(run)
         {
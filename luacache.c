@@ -0,0 +1,375 @@
+/*
+ * luacache.c - Lua bytecode cache
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Parsing rc.lua and the Lua libraries it requires takes most of the startup
+ * time, which is paid again on every restart. Instead, the compiled chunks
+ * are dumped to $XDG_CACHE_HOME/awesome/bytecode and loaded from there as
+ * long as the source file did not change. Each cache file starts with a
+ * header recording the source path, its modification time (with nanoseconds,
+ * so that an edit within the same second is noticed), size and inode,
+ * and the Lua version; any mismatch makes us load the source again and
+ * replace the cache file. Libraries go through the same code thanks to a
+ * searcher inserted in front of the standard Lua file searcher.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <lauxlib.h>
+
+#include "config.h"
+#ifdef WITH_LUAJIT
+#include <luajit.h>
+#define LUACACHE_VERSION LUAJIT_VERSION
+#else
+#define LUACACHE_VERSION LUA_RELEASE
+#endif
+
+#include "luacache.h"
+#include "luaa.h"
+#include "common/buffer.h"
+#include "common/util.h"
+
+#define LUACACHE_MAGIC "AWBC"
+
+/** Header of a cache file, followed by the source path and the bytecode */
+typedef struct
+{
+    char magic[4];
+    char version[28];
+    int64_t mtime;
+    int64_t mtime_nsec;
+    int64_t size;
+    uint64_t inode;
+    uint32_t path_len;
+} luacache_header_t;
+
+/** Whether the cache is used, cleared by --no-bytecode-cache */
+bool luacache_enabled = true;
+
+/** The cache directory, NULL if it could not be created */
+static char *luacache_dir;
+
+/** Create a directory only accessible to the user if it does not exist.
+ * \param path The directory.
+ * \param private Whether the directory must also be owned by the user and
+ * not writable by anyone else, since bytecode is not verified when loaded.
+ * \return True if the directory exists.
+ */
+static bool
+luacache_mkdir(const char *path, bool private)
+{
+    struct stat st;
+
+    if(mkdir(path, 0700) == 0)
+        return true;
+    if(stat(path, &st) || !S_ISDIR(st.st_mode))
+        return false;
+    if(private && (st.st_uid != getuid() || (st.st_mode & (S_IWGRP | S_IWOTH))))
+    {
+        warn("not using bytecode cache %s: it is not private to the user", path);
+        return false;
+    }
+    return true;
+}
+
+/** Get the cache file name of a source file.
+ * \param path The source file.
+ * \return A new string, to be freed by the caller.
+ */
+static char *
+luacache_filename(const char *path)
+{
+    /* FNV-1a */
+    uint64_t hash = 14695981039346656037ULL;
+    buffer_t buf;
+
+    for(; *path; path++)
+    {
+        hash ^= (unsigned char) *path;
+        hash *= 1099511628211ULL;
+    }
+
+    buffer_init(&buf);
+    buffer_addf(&buf, "%s/%016llx.luac", luacache_dir, (unsigned long long) hash);
+    return buffer_detach(&buf);
+}
+
+/** Fill the header of a cache file.
+ * \param header The header.
+ * \param path The source file.
+ * \param st The source file status.
+ */
+static void
+luacache_header(luacache_header_t *header, const char *path, const struct stat *st)
+{
+    p_clear(header, 1);
+    memcpy(header->magic, LUACACHE_MAGIC, sizeof(header->magic));
+    a_strcpy(header->version, sizeof(header->version), LUACACHE_VERSION);
+    header->mtime = st->st_mtim.tv_sec;
+    header->mtime_nsec = st->st_mtim.tv_nsec;
+    header->size = st->st_size;
+    header->inode = st->st_ino;
+    header->path_len = a_strlen(path);
+}
+
+/** Load a chunk from its cache file if it is still valid.
+ * \param L The Lua VM state.
+ * \param path The source file.
+ * \param cache The cache file.
+ * \param header The expected header.
+ * \return True if the chunk was pushed on the stack.
+ */
+static bool
+luacache_read(lua_State *L, const char *path, const char *cache,
+              const luacache_header_t *header)
+{
+    FILE *f = fopen(cache, "rb");
+    struct stat st;
+    char *data;
+    size_t offset = sizeof(*header) + header->path_len;
+    bool ret = false;
+
+    if(!f)
+        return false;
+
+    if(fstat(fileno(f), &st) || (size_t) st.st_size <= offset)
+    {
+        fclose(f);
+        return false;
+    }
+
+    data = p_new(char, st.st_size);
+    if(fread(data, 1, st.st_size, f) == (size_t) st.st_size
+       && !memcmp(data, header, sizeof(*header))
+       && !memcmp(data + sizeof(*header), path, header->path_len))
+    {
+        /* The chunk name is only used for errors in the binary chunk itself,
+         * the functions keep the source name they were compiled with. */
+        if(luaL_loadbuffer(L, data + offset, st.st_size - offset, cache) == 0)
+            ret = true;
+        else
+        {
+            warn("ignoring invalid bytecode cache %s: %s", cache, lua_tostring(L, -1));
+            lua_pop(L, 1);
+        }
+    }
+
+    p_delete(&data);
+    fclose(f);
+    return ret;
+}
+
+/** lua_Writer collecting the dumped chunk in a buffer. */
+static int
+luacache_writer(lua_State *L, const void *p, size_t size, void *buf)
+{
+    buffer_add(buf, p, size);
+    return 0;
+}
+
+/** Dump the chunk on top of the stack to its cache file. The file is written
+ * aside and renamed, so that another awesome never reads a partial file.
+ * \param L The Lua VM state.
+ * \param path The source file.
+ * \param cache The cache file.
+ * \param header The header to write.
+ */
+static void
+luacache_write(lua_State *L, const char *path, const char *cache,
+               const luacache_header_t *header)
+{
+    buffer_t buf, tmp;
+    int fd;
+    FILE *f;
+    bool ok;
+
+    buffer_init(&buf);
+    buffer_add(&buf, header, sizeof(*header));
+    buffer_add(&buf, path, header->path_len);
+    if(lua_dump(L, luacache_writer, &buf))
+    {
+        buffer_wipe(&buf);
+        return;
+    }
+
+    buffer_init(&tmp);
+    buffer_addf(&tmp, "%s.XXXXXX", cache);
+    fd = mkstemp(tmp.s);
+    if(fd < 0 || !(f = fdopen(fd, "wb")))
+    {
+        if(fd >= 0)
+        {
+            close(fd);
+            unlink(tmp.s);
+        }
+        warn("cannot write bytecode cache %s: %s", cache, strerror(errno));
+        buffer_wipe(&tmp);
+        buffer_wipe(&buf);
+        return;
+    }
+
+    ok = fwrite(buf.s, 1, buf.len, f) == (size_t) buf.len;
+    ok = fclose(f) == 0 && ok;
+    if(!ok || rename(tmp.s, cache))
+    {
+        warn("cannot write bytecode cache %s: %s", cache, strerror(errno));
+        unlink(tmp.s);
+    }
+
+    buffer_wipe(&tmp);
+    buffer_wipe(&buf);
+}
+
+/** Load a Lua file, from the bytecode cache if possible. This behaves like
+ * luaL_loadfile().
+ * \param L The Lua VM state.
+ * \param path The file to load.
+ * \return 0 on success, otherwise an error code with a message pushed.
+ */
+int
+luacache_loadfile(lua_State *L, const char *path)
+{
+    luacache_header_t header;
+    struct stat st;
+    char *cache;
+    int ret;
+
+    if(!luacache_enabled || !luacache_dir
+       || stat(path, &st) || !S_ISREG(st.st_mode))
+        return luaL_loadfile(L, path);
+
+    luacache_header(&header, path, &st);
+    cache = luacache_filename(path);
+
+    if(luacache_read(L, path, cache, &header))
+    {
+        p_delete(&cache);
+        return 0;
+    }
+
+    ret = luaL_loadfile(L, path);
+    if(ret == 0)
+        luacache_write(L, path, cache, &header);
+
+    p_delete(&cache);
+    return ret;
+}
+
+/** Package searcher loading Lua modules through the cache. It looks for the
+ * module in package.path like the standard Lua file searcher, which comes
+ * right after it and handles the modules not found or not loadable here.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luacache_searcher(lua_State *L)
+{
+    const char *name = luaL_checkstring(L, 1);
+    const char *path, *template;
+
+    if(!luacache_enabled || !luacache_dir)
+        return 0;
+
+    name = luaL_gsub(L, name, ".", LUA_DIRSEP);
+    lua_getglobal(L, "package");
+    lua_getfield(L, -1, "path");
+    path = lua_tostring(L, -1);
+    if(!path)
+        return 0;
+
+    while(*path)
+    {
+        size_t len;
+        const char *end = strchr(path, *LUA_PATHSEP);
+
+        len = end ? (size_t) (end - path) : a_strlen(path);
+        lua_pushlstring(L, path, len);
+        template = lua_tostring(L, -1);
+        path += end ? len + 1 : len;
+        if(!len)
+        {
+            lua_pop(L, 1);
+            continue;
+        }
+
+        const char *filename = luaL_gsub(L, template, LUA_PATH_MARK, name);
+        if(access(filename, R_OK) == 0)
+        {
+            if(luacache_loadfile(L, filename))
+                /* Let the standard searcher report the error */
+                return 0;
+            lua_pushstring(L, filename);
+            return 2;
+        }
+        lua_pop(L, 2);
+    }
+
+    return 0;
+}
+
+/** Set up the cache directory and install the package searcher.
+ * \param L The Lua VM state.
+ * \param xdg An xdg handle to use to get XDG basedir.
+ */
+void
+luacache_init(lua_State *L, xdgHandle *xdg)
+{
+    const char *home = xdgCacheHome(xdg);
+    buffer_t buf;
+
+    if(home && luacache_mkdir(home, false))
+    {
+        buffer_init(&buf);
+        buffer_addf(&buf, "%s/awesome", home);
+        if(luacache_mkdir(buf.s, false))
+        {
+            buffer_addsl(&buf, "/bytecode");
+            if(luacache_mkdir(buf.s, true))
+                luacache_dir = buffer_detach(&buf);
+        }
+        buffer_wipe(&buf);
+    }
+
+    /* Insert the searcher after package.preload */
+    lua_getglobal(L, "package");
+#if LUA_VERSION_NUM >= 502
+    lua_getfield(L, -1, "searchers");
+#else
+    lua_getfield(L, -1, "loaders");
+#endif
+    if(lua_istable(L, -1))
+    {
+        for(int i = luaA_rawlen(L, -1); i >= 2; i--)
+        {
+            lua_rawgeti(L, -1, i);
+            lua_rawseti(L, -2, i + 1);
+        }
+        lua_pushcfunction(L, luacache_searcher);
+        lua_rawseti(L, -2, 2);
+    }
+    lua_pop(L, 2);
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
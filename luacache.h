@@ -0,0 +1,34 @@
+/*
+ * luacache.h - Lua bytecode cache header
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef AWESOME_LUACACHE_H
+#define AWESOME_LUACACHE_H
+
+#include <stdbool.h>
+#include <lua.h>
+#include <basedir.h>
+
+extern bool luacache_enabled;
+
+void luacache_init(lua_State *, xdgHandle *);
+int luacache_loadfile(lua_State *, const char *);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
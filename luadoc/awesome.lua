@@ -26,13 +26,32 @@ module("awesome")
 -- @class function
 
 --- Restart awesome.
+-- The clients are handed over to the new instance with their geometry, tags
+-- and properties, so that they are not fetched again.
 -- @param -
 -- @name restart
 -- @class function
 
+--- Get or set a string handed over to the next instance on restart.
+-- Each owner has its own string, so that modules do not overwrite each
+-- other's state. awful uses the "awful.client" owner to keep its client
+-- properties and marks across restarts.
+-- @param owner The owner of the state, like the name of the module saving it.
+-- @param state Optional string to hand over if awesome restarts, or nil to
+-- hand nothing over. Without it, the string handed over by the previous
+-- instance for this owner is returned instead.
+-- @return With only the owner, the string from the previous instance, or nil.
+-- It is only available while the configuration file is loaded.
+-- @name restart_state
+-- @class function
+
 --- Spawn a program.
 -- @param cmd The command to launch.
 -- @param use_sn Use startup-notification, true or false, default to true.
+-- @param callbacks Optional table of callbacks watching the process without
+-- blocking: stdout and stderr are called with the program output, exit is
+-- called with the exit reason ("exit" or "signal") and code once the output
+-- has been read, and output selects "line" (default) or "chunk" delivery.
 -- @return Process ID if everything is OK, or an error string if an error occured.
 
 --- Load an image
@@ -41,6 +60,120 @@ module("awesome")
 -- @name load_image
 -- @class function
 
+--- List the files of a directory with their modification time.
+-- @param path The directory path.
+-- @param suffix Optional suffix the file names must end with.
+-- @param all If true, hidden files and directories are listed too,
+-- directories with a trailing slash.
+-- @param executable If true, only the regular files the user can execute are
+-- listed.
+-- @return A table mapping file names to modification times and the
+-- modification time of the directory, or nil and an error string.
+-- @name scandir
+-- @class function
+
+--- Watch a directory for changes.
+-- @param path The directory path.
+-- @param func The function to call with the name of the changed file, or nil
+-- if the directory itself changed, and true if the directory is not watched
+-- anymore, for example because it was deleted.
+-- @return True if the directory is watched, false and an error otherwise.
+-- @name watchdir
+-- @class function
+
+--- Stop watching a directory.
+-- @param path The directory path, as given to watchdir.
+-- @param func Optional function to remove, otherwise all the functions
+-- watching the directory are removed.
+-- @return True if a function was removed.
+-- @name unwatchdir
+-- @class function
+
+--- Tune the Lua garbage collector and get its statistics. By default, the
+-- automatic collector is stopped and collection cycles run in slices while
+-- the main loop is idle, so that they do not delay input handling.
+-- @param settings Optional table with the enabled (use slices from the main
+-- loop rather than Lua's automatic collector), pause (memory growth in percent
+-- before a new cycle starts), stepmul (collector speed relative to allocation,
+-- in percent) and slice (maximum duration of a slice, in seconds) fields.
+-- @return A table with the current settings, the memory use and the
+-- threshold of the next cycle in KiB, and the number of cycles, slices and
+-- the time spent collecting.
+-- @name gc
+-- @class function
+
+--- Start recording main loop iterations. Any previous data is discarded.
+-- @param size Optional number of iterations to keep, defaults to 1024.
+-- @name profiler.start
+-- @class function
+
+--- Stop recording main loop iterations. The recorded data stays available.
+-- @name profiler.stop
+-- @class function
+
+--- Discard the recorded data, including the cost of signal handlers and the
+-- X request counts.
+-- @name profiler.reset
+-- @class function
+
+--- Check whether the profiler is recording.
+-- @return True if recording.
+-- @name profiler.running
+-- @class function
+
+--- Get the recorded main loop iterations, oldest first.
+-- @return A table of iterations. Each one has the timestamp, events and
+-- requests fields, the total time and a time table with the wall time spent
+-- in the dispatch, lua_refresh, banning, stack, focus, flush and gc phases.
+-- @name profiler.samples
+-- @class function
+
+--- Get statistics about the handled X events.
+-- @return A table indexed by event name of tables with the count, total and
+-- max fields.
+-- @name profiler.events
+-- @class function
+
+--- Start accounting the CPU time, calls and Lua memory allocations of every
+-- signal handler.
+-- @name profiler.start_signals
+-- @class function
+
+--- Stop accounting the cost of signal handlers.
+-- @name profiler.stop_signals
+-- @class function
+
+--- Get the cost of the signal handlers called while accounting was enabled.
+-- @return A table of tables, one per signal and handler, with the signal name,
+-- the source location of the handler, the number of calls, the total and max
+-- CPU time in seconds and the Lua memory allocated in KiB.
+-- @name profiler.signals
+-- @class function
+
+--- Start counting X requests and round trips by call site. This needs awesome
+-- to be built with WITH_XCB_TRACE. Round trips made while dispatching events
+-- or refreshing are reported on stderr the first time a call site does one.
+-- @return True if counting started, false if not supported.
+-- @name profiler.start_xcb
+-- @class function
+
+--- Stop counting X requests and round trips.
+-- @name profiler.stop_xcb
+-- @class function
+
+--- Get the X requests and round trips of each call site.
+-- @return A table of tables with the site (a symbol and offset in awesome),
+-- requests, round_trips and in_loop fields, the latter being the number of
+-- round trips made while dispatching events or refreshing.
+-- @name profiler.xcb_sites
+-- @class function
+
+--- Get the number of X requests sent.
+-- @return A table indexed by request name, or extension name for extension
+-- requests, of counts.
+-- @name profiler.xcb_requests
+-- @class function
+
 --- Add a global signal.
 -- @param name A string with the event name.
 -- @param func The function to call.
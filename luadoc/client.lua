@@ -50,6 +50,13 @@ module("client")
 -- @name get
 -- @class function
 
+--- Get the nearest visible client in a direction, on the same screen.
+-- @param c The client to start from.
+-- @param dir The direction, can be either "up", "down", "left" or "right".
+-- @return The nearest client, or nil if there is none.
+-- @name find_in_direction
+-- @class function
+
 --- Check if a client is visible on its screen.
 -- @param -
 -- @return A boolean value, true if the client is visible, false otherwise.
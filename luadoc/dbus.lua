@@ -31,8 +31,12 @@ module("dbus")
 -- @class function
 
 --- Add a signal receiver on the D-Bus.
+-- The function receives a table with the message type, interface, path,
+-- member and bus, followed by the message arguments.
 -- @param interface A string with the interface name.
 -- @param func The function to call.
+-- @param members Optional table of member names. Messages for other members
+-- of the interface are dropped before reaching Lua.
 -- @name connect_signal
 -- @class function
 
@@ -41,3 +45,33 @@ module("dbus")
 -- @param func The function to call.
 -- @name disconnect_signal
 -- @class function
+
+--- Call a D-Bus method without blocking.
+-- @param bus A string indicating if we are using system or session bus.
+-- @param dest The destination name.
+-- @param path The object path.
+-- @param interface The interface name.
+-- @param method The method name.
+-- @param args A table of arguments, given as a list of D-Bus type and value
+-- pairs like the values returned by method handlers, or nil.
+-- @param callback Optional function called once the reply arrives, with true
+-- followed by the reply arguments, or false, the error name and the error
+-- message. Without callback, no reply is requested.
+-- @param timeout Optional reply timeout in seconds.
+-- @return True if the call was sent, nil and an error message otherwise.
+-- @name call
+-- @class function
+
+--- Set the number of messages processed per bus and per main loop iteration.
+-- Messages left over are processed on the next iterations, so that X events
+-- are not delayed by a busy bus.
+-- @param budget The number of messages, or nil for the default of 64.
+-- @name set_budget
+-- @class function
+
+--- Get the message counters of the buses.
+-- @return A table with a session and a system table, each with the number of
+-- messages processed by Lua handlers, dropped because nobody listens to them,
+-- and the number of times messages were deferred to a later iteration.
+-- @name get_stats
+-- @class function
@@ -7,6 +7,12 @@ module("tag")
 -- @field name Tag name.
 -- @field screen Screen number of the tag.
 -- @field selected True if the client is selected to be viewed.
+-- @field mwfact Master width factor, 0.5 by default.
+-- @field nmaster Number of master clients, 1 by default.
+-- @field ncol Number of columns, 1 by default.
+-- @field hide True if the tag is hidden from the taglist.
+-- @field icon_only True if only the tag icon is shown in the taglist.
+-- @field layout The layout of the tag.
 -- @class table
 -- @name tag
 
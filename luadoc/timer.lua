@@ -8,6 +8,10 @@ module("timer")
 -- @field timeout Interval in seconds to emit the timeout signal.
 -- Can be any value, including floating ones (i.e. 1.5 second).
 -- @field started Read-only boolean field indicating if the timer has been started.
+-- @field slack How many seconds late the timer may fire, 0 by default. Timers
+-- with a slack fire together whenever their slacks allow it, so that awesome
+-- wakes up and redraws less often. The slack does not stretch the period:
+-- on average, the timer still fires every timeout.
 -- @class table
 -- @name timer
 
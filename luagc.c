@@ -0,0 +1,245 @@
+/*
+ * luagc.c - Lua garbage collector scheduling
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Lua collects garbage incrementally, doing some work whenever enough memory
+ * was allocated. That work then happens in the middle of whatever Lua code is
+ * running, e.g. a key binding or a redraw. Instead, the automatic collector is
+ * stopped and a collection cycle is run in bounded slices whenever the main
+ * loop is idle. Should the loop never get idle while memory keeps growing, a
+ * slice is also run before each poll.
+ */
+
+#include "luagc.h"
+#include "globalconf.h"
+#include "luaa.h"
+#include "profiler.h"
+
+/** Amount of work done by one collector step, in KiB */
+#define LUAGC_STEP_SIZE 16
+
+static struct
+{
+    /** Whether collection is scheduled by us rather than by Lua */
+    bool enabled;
+    /** Whether luagc_init() was called */
+    bool started;
+    /** Memory growth in percent after which a new cycle starts */
+    int pause;
+    /** Speed of the collector relative to allocation, in percent */
+    int stepmul;
+    /** Maximum duration of a slice of collection */
+    ev_tstamp slice;
+    /** Memory use in KiB at which the next cycle starts */
+    int threshold;
+    /** Whether a cycle is in progress */
+    bool collecting;
+    ev_idle idle;
+    ev_prepare prepare;
+    /** Statistics */
+    unsigned int cycles, slices;
+    ev_tstamp time;
+} luagc =
+{
+    .enabled = true,
+    .pause = 200,
+    .stepmul = 200,
+    .slice = 0.002,
+};
+
+/** Set the threshold for the next cycle from the current memory use.
+ * \param L The Lua VM state.
+ */
+static void
+luagc_set_threshold(lua_State *L)
+{
+    luagc.threshold = lua_gc(L, LUA_GCCOUNT, 0) * luagc.pause / 100;
+}
+
+/** Run collector steps for at most one slice.
+ * \param L The Lua VM state.
+ */
+static void
+luagc_run_slice(lua_State *L)
+{
+    ev_tstamp start = ev_time();
+
+    profiler_begin();
+    luagc.slices++;
+
+    do
+    {
+        if(lua_gc(L, LUA_GCSTEP, LUAGC_STEP_SIZE))
+        {
+            /* The cycle is finished */
+            luagc.collecting = false;
+            luagc.cycles++;
+            luagc_set_threshold(L);
+            break;
+        }
+    } while(ev_time() - start < luagc.slice);
+
+    /* With Lua 5.1, a step restarts the automatic collector */
+    lua_gc(L, LUA_GCSTOP, 0);
+
+    luagc.time += ev_time() - start;
+    profiler_mark(PROFILER_PHASE_GC);
+}
+
+static void
+luagc_idle_cb(EV_P_ ev_idle *w, int revents)
+{
+    luagc_run_slice(globalconf.L);
+    if(!luagc.collecting)
+        ev_idle_stop(EV_A_ w);
+}
+
+static void
+luagc_prepare_cb(EV_P_ ev_prepare *w, int revents)
+{
+    int count = lua_gc(globalconf.L, LUA_GCCOUNT, 0);
+
+    /* With Lua 5.1, collectgarbage("collect") or collectgarbage("step") from
+     * the configuration restarts the automatic collector: stop it again */
+    lua_gc(globalconf.L, LUA_GCSTOP, 0);
+
+    if(!luagc.collecting && count >= luagc.threshold)
+    {
+        luagc.collecting = true;
+        ev_idle_start(EV_A_ &luagc.idle);
+    }
+
+    /* Idle watchers do not run while events keep coming: make sure memory
+     * does not grow without bounds meanwhile */
+    if(luagc.collecting && count >= 2 * luagc.threshold)
+        luagc_run_slice(globalconf.L);
+}
+
+/** Apply the settings to the Lua state and the watchers.
+ */
+static void
+luagc_apply(void)
+{
+    lua_State *L = globalconf.L;
+
+    lua_gc(L, LUA_GCSETPAUSE, luagc.pause);
+    lua_gc(L, LUA_GCSETSTEPMUL, luagc.stepmul);
+
+    if(!luagc.started)
+        return;
+
+    if(luagc.enabled)
+    {
+        lua_gc(L, LUA_GCSTOP, 0);
+        luagc_set_threshold(L);
+        if(!ev_is_active(&luagc.prepare))
+        {
+            ev_prepare_start(globalconf.loop, &luagc.prepare);
+            ev_unref(globalconf.loop);
+        }
+    }
+    else
+    {
+        if(ev_is_active(&luagc.prepare))
+        {
+            ev_ref(globalconf.loop);
+            ev_prepare_stop(globalconf.loop, &luagc.prepare);
+        }
+        ev_idle_stop(globalconf.loop, &luagc.idle);
+        luagc.collecting = false;
+        lua_gc(L, LUA_GCRESTART, 0);
+    }
+}
+
+/** Start scheduling garbage collection from the main loop.
+ */
+void
+luagc_init(void)
+{
+    ev_idle_init(&luagc.idle, luagc_idle_cb);
+    ev_set_priority(&luagc.idle, EV_MINPRI);
+    ev_prepare_init(&luagc.prepare, luagc_prepare_cb);
+    ev_set_priority(&luagc.prepare, EV_MINPRI);
+    luagc.started = true;
+    luagc_apply();
+}
+
+/** Tune the garbage collector and get its statistics.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam An optional table with the enabled, pause, stepmul and slice fields.
+ * \lreturn A table with the current settings, the memory use and threshold in
+ * KiB, and the number of cycles, slices and time spent collecting.
+ */
+int
+luaA_gc(lua_State *L)
+{
+    if(!lua_isnoneornil(L, 1))
+    {
+        bool enabled, was_enabled = luagc.enabled;
+        int pause, stepmul;
+        ev_tstamp slice;
+
+        luaA_checktable(L, 1);
+        enabled = luaA_getopt_boolean(L, 1, "enabled", luagc.enabled);
+        pause = luaA_getopt_number(L, 1, "pause", luagc.pause);
+        stepmul = luaA_getopt_number(L, 1, "stepmul", luagc.stepmul);
+        slice = luaA_getopt_number(L, 1, "slice", luagc.slice);
+
+        if(pause < 100 || stepmul <= 0 || slice <= 0)
+            luaL_error(L, "invalid garbage collector settings");
+
+        luagc.pause = pause;
+        luagc.stepmul = stepmul;
+        luagc.slice = slice;
+        luagc.enabled = enabled;
+        if(enabled != was_enabled)
+            luagc_apply();
+        else
+        {
+            lua_gc(L, LUA_GCSETPAUSE, luagc.pause);
+            lua_gc(L, LUA_GCSETSTEPMUL, luagc.stepmul);
+        }
+    }
+
+    lua_createtable(L, 0, 9);
+    lua_pushboolean(L, luagc.enabled);
+    lua_setfield(L, -2, "enabled");
+    lua_pushnumber(L, luagc.pause);
+    lua_setfield(L, -2, "pause");
+    lua_pushnumber(L, luagc.stepmul);
+    lua_setfield(L, -2, "stepmul");
+    lua_pushnumber(L, luagc.slice);
+    lua_setfield(L, -2, "slice");
+    lua_pushnumber(L, lua_gc(L, LUA_GCCOUNT, 0));
+    lua_setfield(L, -2, "memory");
+    lua_pushnumber(L, luagc.threshold);
+    lua_setfield(L, -2, "threshold");
+    lua_pushnumber(L, luagc.cycles);
+    lua_setfield(L, -2, "cycles");
+    lua_pushnumber(L, luagc.slices);
+    lua_setfield(L, -2, "slices");
+    lua_pushnumber(L, luagc.time);
+    lua_setfield(L, -2, "time");
+    return 1;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
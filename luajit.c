@@ -0,0 +1,127 @@
+/*
+ * luajit.c - LuaJIT FFI entry points
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Layouts and other hot Lua code read a few client and tag fields many times
+ * per refresh. Going through the object __index metamethod costs a class
+ * lookup, a property lookup and a C function call each time, and LuaJIT
+ * cannot compile a trace across it. With LuaJIT, these accessors are called
+ * through the FFI instead: the Lua userdata of an object is its C structure,
+ * so the FFI passes it as a plain pointer and the call is compiled inline. */
+
+#include "luajit.h"
+
+#ifdef WITH_LUAJIT
+
+/** Get the geometry of a client. The returned pointer is only valid as long
+ * as the client is.
+ * \param c The client.
+ * \return The client geometry, including its border.
+ */
+const area_t *
+awesome_ffi_client_geometry(const client_t *c)
+{
+    return &c->geometry;
+}
+
+/** Get the border width of a client.
+ * \param c The client.
+ * \return The border width.
+ */
+int
+awesome_ffi_client_border_width(const client_t *c)
+{
+    return c->border_width;
+}
+
+/** Check if a client is visible, see client_isvisible().
+ * \param c The client.
+ * \return True if the client is visible.
+ */
+bool
+awesome_ffi_client_isvisible(client_t *c)
+{
+    return client_isvisible(c);
+}
+
+/** Check if a client is tagged with a tag.
+ * \param c The client.
+ * \param t The tag.
+ * \return True if the client is tagged with t.
+ */
+bool
+awesome_ffi_client_istagged(client_t *c, tag_t *t)
+{
+    return is_client_tagged(c, t);
+}
+
+/** Check if a tag is selected.
+ * \param t The tag.
+ * \return True if the tag is selected.
+ */
+bool
+awesome_ffi_tag_selected(tag_t *t)
+{
+    return tag_get_selected(t);
+}
+
+/** Get the master width factor of a tag.
+ * \param t The tag.
+ * \return The master width factor.
+ */
+double
+awesome_ffi_tag_mwfact(tag_t *t)
+{
+    return tag_get_mwfact(t);
+}
+
+/** Get the number of master clients of a tag.
+ * \param t The tag.
+ * \return The number of master clients.
+ */
+int
+awesome_ffi_tag_nmaster(tag_t *t)
+{
+    return tag_get_nmaster(t);
+}
+
+/** Get the number of columns of a tag.
+ * \param t The tag.
+ * \return The number of columns.
+ */
+int
+awesome_ffi_tag_ncol(tag_t *t)
+{
+    return tag_get_ncol(t);
+}
+
+/** Get the number of clients tagged with a tag.
+ * \param t The tag.
+ * \return The number of clients.
+ */
+int
+awesome_ffi_tag_client_count(tag_t *t)
+{
+    return tag_get_client_count(t);
+}
+
+#endif
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,46 @@
+/*
+ * luajit.h - LuaJIT FFI entry points header
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef AWESOME_LUAJIT_H
+#define AWESOME_LUAJIT_H
+
+#include "config.h"
+
+#ifdef WITH_LUAJIT
+#include "objects/client.h"
+#include "objects/tag.h"
+
+/* These functions are not called from C: lib/awful/ffi.lua declares them
+ * with ffi.cdef() and calls them through ffi.C, which the executable exports
+ * since it is linked with -export-dynamic. Keep both declarations in sync. */
+
+const area_t *awesome_ffi_client_geometry(const client_t *);
+int awesome_ffi_client_border_width(const client_t *);
+bool awesome_ffi_client_isvisible(client_t *);
+bool awesome_ffi_client_istagged(client_t *, tag_t *);
+bool awesome_ffi_tag_selected(tag_t *);
+double awesome_ffi_tag_mwfact(tag_t *);
+int awesome_ffi_tag_nmaster(tag_t *);
+int awesome_ffi_tag_ncol(tag_t *);
+int awesome_ffi_tag_client_count(tag_t *);
+#endif
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -27,6 +27,7 @@
 #include "screen.h"
 #include "systray.h"
 #include "property.h"
+#include "restart.h"
 #include "spawn.h"
 #include "luaa.h"
 #include "xwindow.h"
@@ -41,6 +42,7 @@ static void
 client_wipe(client_t *c)
 {
     key_array_wipe(&c->keys);
+    bitset_wipe(&c->tags);
     xcb_icccm_get_wm_protocols_reply_wipe(&c->protocols);
     p_delete(&c->machine);
     p_delete(&c->class);
@@ -146,11 +148,7 @@ client_maybevisible(client_t *c)
     if(c->sticky)
         return true;
 
-    foreach(tag, c->screen->tags)
-        if(tag_get_selected(*tag) && is_client_tagged(c, *tag))
-            return true;
-
-    return false;
+    return bitset_intersects(&c->tags, &c->screen->selected_tags);
 }
 
 /** Get a client by its window.
@@ -246,37 +244,33 @@ client_ban(client_t *c)
 
 /** This is part of The Bob Marley Algorithm: we ignore enter and leave window
  * in certain cases, like map/unmap or move, so we don't get spurious events.
+ * Instead of changing the event mask of every client, we remember the range
+ * of request sequence numbers sent until client_restore_enterleave_events()
+ * and drop the enter/leave events the server generates while processing them.
+ * Calls may be nested.
  */
 void
 client_ignore_enterleave_events(void)
 {
-    foreach(c, globalconf.clients)
-    {
-        xcb_change_window_attributes(globalconf.connection,
-                                     (*c)->window,
-                                     XCB_CW_EVENT_MASK,
-                                     (const uint32_t []) { CLIENT_SELECT_INPUT_EVENT_MASK & ~(XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_LEAVE_WINDOW) });
-        xcb_change_window_attributes(globalconf.connection,
-                                     (*c)->frame_window,
-                                     XCB_CW_EVENT_MASK,
-                                     (const uint32_t []) { FRAME_SELECT_INPUT_EVENT_MASK & ~(XCB_EVENT_MASK_ENTER_WINDOW | XCB_EVENT_MASK_LEAVE_WINDOW) });
-    }
+    if(globalconf.pending_enter_leave_depth++ > 0)
+        return;
+
+    globalconf.pending_enter_leave_begin =
+        xcb_no_operation(globalconf.connection).sequence;
 }
 
 void
 client_restore_enterleave_events(void)
 {
-    foreach(c, globalconf.clients)
-    {
-        xcb_change_window_attributes(globalconf.connection,
-                                     (*c)->window,
-                                     XCB_CW_EVENT_MASK,
-                                     (const uint32_t []) { CLIENT_SELECT_INPUT_EVENT_MASK });
-        xcb_change_window_attributes(globalconf.connection,
-                                     (*c)->frame_window,
-                                     XCB_CW_EVENT_MASK,
-                                     (const uint32_t []) { FRAME_SELECT_INPUT_EVENT_MASK });
-    }
+    sequence_pair_t pair;
+
+    assert(globalconf.pending_enter_leave_depth > 0);
+    if(--globalconf.pending_enter_leave_depth > 0)
+        return;
+
+    pair.begin = globalconf.pending_enter_leave_begin;
+    pair.end = xcb_no_operation(globalconf.connection).sequence;
+    sequence_pair_array_append(&globalconf.ignore_enter_leave_events, pair);
 }
 
 /** Record that a client got focus.
@@ -422,6 +416,11 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, bool startup)
         return;
     }
 
+    /* Put clients of the previous instance back where they were */
+    xcb_get_geometry_reply_t restored_geom;
+    if(startup && restart_client_geometry(w, &restored_geom))
+        wgeom = &restored_geom;
+
     /* If this is a new client that just has been launched, then request its
      * startup id. */
     xcb_get_property_cookie_t startup_id_q = { 0 };
@@ -522,6 +521,8 @@ HANDLE_GEOM(width)
 HANDLE_GEOM(height)
 #undef HANDLE_GEOM
 
+    spatial_need_update(c->screen);
+
     luaA_object_emit_signal(globalconf.L, -1, "property::geometry", 0);
 
     /* Set border width */
@@ -531,12 +532,16 @@ HANDLE_GEOM(height)
     c->size_hints_honor = true;
     luaA_object_emit_signal(globalconf.L, -1, "property::size_hints_honor", 0);
 
-    /* update all properties */
-    client_update_properties(c);
+    /* update all properties, unless the previous instance handed them over */
+    if(!startup || !restart_client_restore(c))
+        client_update_properties(c);
 
     /* Then check clients hints */
     ewmh_client_check_hints(c);
 
+    if(startup)
+        restart_client_restore_tags(c);
+
     /* Push client in stack */
     client_raise(c);
 
@@ -622,6 +627,7 @@ client_resize(client_t *c, area_t geometry)
         /* Also store geometry including border */
         area_t old_geometry = c->geometry;
         c->geometry = geometry;
+        spatial_need_update(c->screen);
 
         /* Ignore all spurious enter/leave notify events */
         client_ignore_enterleave_events();
@@ -920,6 +926,7 @@ client_unmanage(client_t *c, bool window_valid)
             break;
         }
     stack_client_remove(c);
+    spatial_need_update(c->screen);
     for(int i = 0; i < tags->len; i++)
         untag_client(c, tags->tab[i]);
 
@@ -1033,6 +1040,24 @@ luaA_client_get(lua_State *L)
     return 1;
 }
 
+/** Get the nearest visible client in a direction.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam A client to start from.
+ * \lparam The direction, can be either "up", "down", "left" or "right".
+ * \lreturn The nearest client on the same screen, or nothing.
+ */
+static int
+luaA_client_find_in_direction(lua_State *L)
+{
+    static const char *directions[] = { "up", "down", "left", "right", NULL };
+    client_t *c = luaA_checkudata(L, 1, &client_class);
+    spatial_direction_t dir = luaL_checkoption(L, 2, NULL, directions);
+
+    return luaA_object_push(L, spatial_find_in_direction(c, dir));
+}
+
 /** Check if a client is visible on its screen.
  * \param L The Lua VM state.
  * \return The number of elements pushed on stack.
@@ -1129,34 +1154,7 @@ luaA_client_tags(lua_State *L)
     int j = 0;
 
     if(lua_gettop(L) == 2)
-    {
-        luaA_checktable(L, 2);
-        for(int i = 0; i < tags->len; i++)
-        {
-            /* Only untag if we aren't going to add this tag again */
-            bool found = false;
-            lua_pushnil(L);
-            while(lua_next(L, 2))
-            {
-                tag_t *t = lua_touserdata(L, -1);
-                /* Pop the value from lua_next */
-                lua_pop(L, 1);
-                if (t != tags->tab[i])
-                    continue;
-
-                /* Pop the key from lua_next */
-                lua_pop(L, 1);
-                found = true;
-                break;
-            }
-            if(!found)
-                untag_client(c, tags->tab[i]);
-        }
-        lua_pushnil(L);
-        while(lua_next(L, 2))
-            tag_client(c);
-        lua_pop(L, 1);
-    }
+        luaA_tag_set_client_tags(L, c, 2);
 
     lua_newtable(L);
     foreach(tag, *tags)
@@ -1666,6 +1664,7 @@ client_class_setup(lua_State *L)
     {
         LUA_CLASS_METHODS(client)
         { "get", luaA_client_get },
+        { "find_in_direction", luaA_client_find_in_direction },
         { "__index", luaA_client_module_index },
         { "__newindex", luaA_client_module_newindex },
         { NULL, NULL }
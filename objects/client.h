@@ -27,6 +27,7 @@
 #include "draw.h"
 #include "banning.h"
 #include "objects/window.h"
+#include "common/bitset.h"
 #include "common/luaobject.h"
 
 #define CLIENT_SELECT_INPUT_EVENT_MASK (XCB_EVENT_MASK_STRUCTURE_NOTIFY \
@@ -101,6 +102,13 @@ struct client_t
     uint32_t pid;
     /** Window it is transient for */
     client_t *transient_for;
+    /** Whether it has WM_TRANSIENT_FOR, even for a window which is not a
+     * client */
+    bool has_transient_for;
+    /** The window in WM_TRANSIENT_FOR */
+    xcb_window_t transient_for_window;
+    /** Tags of the client, indexed by their slot */
+    bitset_t tags;
 };
 
 ARRAY_FUNCS(client_t *, client, DO_NOTHING)
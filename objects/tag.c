@@ -37,11 +37,33 @@ struct tag
     bool selected;
     /** clients in this tag */
     client_array_t clients;
+    /** Stable index of the tag in the client and screen tag bit sets */
+    int slot;
+    /** Master width factor */
+    double mwfact;
+    /** Number of master clients */
+    int nmaster;
+    /** Number of columns */
+    int ncol;
+    /** True if the tag is hidden from the taglist */
+    bool hide;
+    /** True if only the icon is shown in the taglist */
+    bool icon_only;
+    /** Layout, stored in the tag environment table */
+    void *layout;
 };
 
+/** Default values of the layout properties */
+#define TAG_DEFAULT_MWFACT 0.5
+#define TAG_DEFAULT_NMASTER 1
+#define TAG_DEFAULT_NCOL 1
+
 static lua_class_t tag_class;
 LUA_OBJECT_FUNCS(tag_class, tag_t, tag)
 
+/** Slots in use by tags */
+static bitset_t tag_slots;
+
 
 void
 tag_unref_simplified(tag_t **tag)
@@ -54,10 +76,29 @@ tag_wipe(tag_t *tag)
 {
     client_array_wipe(&tag->clients);
     p_delete(&tag->name);
+    bitset_clear(&tag_slots, tag->slot);
+}
+
+static tag_t *
+tag_allocator(lua_State *L)
+{
+    tag_t *tag = tag_new(L);
+
+    tag->slot = bitset_first_clear(&tag_slots);
+    bitset_set(&tag_slots, tag->slot);
+
+    tag->mwfact = TAG_DEFAULT_MWFACT;
+    tag->nmaster = TAG_DEFAULT_NMASTER;
+    tag->ncol = TAG_DEFAULT_NCOL;
+
+    return tag;
 }
 
 OBJECT_EXPORT_PROPERTY(tag, tag_t, selected)
 OBJECT_EXPORT_PROPERTY(tag, tag_t, name)
+OBJECT_EXPORT_PROPERTY(tag, tag_t, mwfact)
+OBJECT_EXPORT_PROPERTY(tag, tag_t, nmaster)
+OBJECT_EXPORT_PROPERTY(tag, tag_t, ncol)
 
 /** View or unview a tag.
  * \param L The Lua VM state.
@@ -74,6 +115,11 @@ tag_view(lua_State *L, int udx, bool view)
 
         if(tag->screen)
         {
+            if(view)
+                bitset_set(&tag->screen->selected_tags, tag->slot);
+            else
+                bitset_clear(&tag->screen->selected_tags, tag->slot);
+
             banning_need_update();
 
             ewmh_update_net_current_desktop();
@@ -101,6 +147,8 @@ tag_append_to_screen(lua_State *L, int udx, screen_t *s)
     }
 
     tag->screen = s;
+    if(tag->selected)
+        bitset_set(&s->selected_tags, tag->slot);
     tag_array_append(&s->tags, luaA_object_ref_class(globalconf.L, udx, &tag_class));
     ewmh_update_net_numbers_of_desktop();
     ewmh_update_net_desktop_names();
@@ -133,7 +181,10 @@ tag_remove_from_screen(tag_t *tag)
 
     /* tag was selected? If so, reban */
     if(tag->selected)
+    {
+        bitset_clear(&tag->screen->selected_tags, tag->slot);
         banning_need_update();
+    }
 
     ewmh_update_net_numbers_of_desktop();
     ewmh_update_net_desktop_names();
@@ -170,16 +221,19 @@ tag_client_emit_signal(lua_State *L, tag_t *t, client_t *c, const char *signame)
 void
 tag_client(client_t *c)
 {
-    tag_t *t = luaA_object_ref_class(globalconf.L, -1, &tag_class);
+    tag_t *t = luaA_checkudata(globalconf.L, -1, &tag_class);
 
     /* don't tag twice */
     if(is_client_tagged(c, t))
     {
-        luaA_object_unref(globalconf.L, t);
+        lua_pop(globalconf.L, 1);
         return;
     }
 
+    luaA_object_ref(globalconf.L, -1);
+
     client_array_append(&t->clients, c);
+    bitset_set(&c->tags, t->slot);
     ewmh_client_update_desktop(c);
     banning_need_update();
 
@@ -193,10 +247,14 @@ tag_client(client_t *c)
 void
 untag_client(client_t *c, tag_t *t)
 {
+    if(!is_client_tagged(c, t))
+        return;
+
     for(int i = 0; i < t->clients.len; i++)
         if(t->clients.tab[i] == c)
         {
             client_array_take(&t->clients, i);
+            bitset_clear(&c->tags, t->slot);
             banning_need_update();
             ewmh_client_update_desktop(c);
             tag_client_emit_signal(globalconf.L, t, c, "untagged");
@@ -213,11 +271,60 @@ untag_client(client_t *c, tag_t *t)
 bool
 is_client_tagged(client_t *c, tag_t *t)
 {
-    for(int i = 0; i < t->clients.len; i++)
-        if(t->clients.tab[i] == c)
-            return true;
+    return bitset_test(&c->tags, t->slot);
+}
+
+/** Get the number of clients tagged with a tag.
+ * \param t The tag.
+ * \return The number of clients.
+ */
+int
+tag_get_client_count(tag_t *t)
+{
+    return t->clients.len;
+}
+
+/** Set the tags of a client from a table, only touching the tags which are
+ * really added or removed.
+ * \param L The Lua VM state.
+ * \param c The client.
+ * \param idx The index of the table of tags on the stack.
+ */
+void
+luaA_tag_set_client_tags(lua_State *L, client_t *c, int idx)
+{
+    bitset_t wanted = { .words = NULL, .len = 0 };
+    tag_array_t *tags = &c->screen->tags;
+
+    idx = luaA_absindex(L, idx);
+    luaA_checktable(L, idx);
+
+    /* Check the types first so that no error can leak the set */
+    lua_pushnil(L);
+    while(lua_next(L, idx))
+    {
+        luaA_checkudata(L, -1, &tag_class);
+        lua_pop(L, 1);
+    }
+
+    lua_pushnil(L);
+    while(lua_next(L, idx))
+    {
+        tag_t *t = lua_touserdata(L, -1);
+        bitset_set(&wanted, t->slot);
+        lua_pop(L, 1);
+    }
+
+    for(int i = 0; i < tags->len; i++)
+        if(!bitset_test(&wanted, tags->tab[i]->slot))
+            untag_client(c, tags->tab[i]);
+
+    bitset_wipe(&wanted);
 
-    return false;
+    /* tag_client() ignores the tags the client already has */
+    lua_pushnil(L);
+    while(lua_next(L, idx))
+        tag_client(c);
 }
 
 /** Get the index of the first selected tag.
@@ -291,36 +398,48 @@ luaA_tag_clients(lua_State *L)
     if(lua_gettop(L) == 2)
     {
         luaA_checktable(L, 2);
-        foreach(c, tag->clients)
+
+        /* Build the set of wanted clients, keyed by their address */
+        lua_newtable(L);
+        lua_pushnil(L);
+        while(lua_next(L, 2))
+        {
+            client_t *c = luaA_checkudata(L, -1, &client_class);
+            lua_pop(L, 1);
+            lua_pushlightuserdata(L, c);
+            lua_pushboolean(L, true);
+            lua_rawset(L, 3);
+        }
+
+        /* Untag the clients which are not wanted anymore. Go backward since
+         * untagging removes the client from the array. */
+        for(i = clients->len - 1; i >= 0; i--)
         {
-            /* Only untag if we aren't going to add this tag again */
-            bool found = false;
-            lua_pushnil(L);
-            while(lua_next(L, 2))
-            {
-                client_t *tc = luaA_checkudata(L, -1, &client_class);
-                /* Pop the value from lua_next */
-                lua_pop(L, 1);
-                if (tc != *c)
-                    continue;
-
-                /* Pop the key from lua_next */
-                lua_pop(L, 1);
-                found = true;
-                break;
-            }
-            if(!found)
-                untag_client(*c, tag);
+            /* Signal handlers may have changed the array */
+            if(i >= clients->len)
+                continue;
+            client_t *c = clients->tab[i];
+            lua_pushlightuserdata(L, c);
+            lua_rawget(L, 3);
+            bool wanted = lua_toboolean(L, -1);
+            lua_pop(L, 1);
+            if(!wanted)
+                untag_client(c, tag);
         }
+
+        /* Tag the new ones, tag_client() ignores those already tagged */
         lua_pushnil(L);
         while(lua_next(L, 2))
         {
-            client_t *c = luaA_checkudata(L, -1, &client_class);
+            client_t *c = lua_touserdata(L, -1);
             /* push tag on top of the stack */
             lua_pushvalue(L, 1);
             tag_client(c);
             lua_pop(L, 1);
         }
+
+        /* Remove the set */
+        lua_pop(L, 1);
     }
 
     lua_createtable(L, clients->len, 0);
@@ -335,6 +454,87 @@ luaA_tag_clients(lua_State *L)
 
 LUA_OBJECT_EXPORT_PROPERTY(tag, tag_t, name, lua_pushstring)
 LUA_OBJECT_EXPORT_PROPERTY(tag, tag_t, selected, lua_pushboolean)
+LUA_OBJECT_EXPORT_PROPERTY(tag, tag_t, mwfact, lua_pushnumber)
+LUA_OBJECT_EXPORT_PROPERTY(tag, tag_t, nmaster, lua_pushnumber)
+LUA_OBJECT_EXPORT_PROPERTY(tag, tag_t, ncol, lua_pushnumber)
+LUA_OBJECT_EXPORT_PROPERTY(tag, tag_t, hide, lua_pushboolean)
+LUA_OBJECT_EXPORT_PROPERTY(tag, tag_t, icon_only, lua_pushboolean)
+
+/** Set a layout property of a tag.
+ * A nil value resets the property to its default.
+ * Signals are only emitted when the value really changes.
+ */
+#define DO_TAG_SET_NUMBER_PROPERTY(prop, type, def) \
+    static int \
+    luaA_tag_set_##prop(lua_State *L, tag_t *tag) \
+    { \
+        type value = lua_isnil(L, -1) ? def : (type) luaL_checknumber(L, -1); \
+        if(tag->prop != value) \
+        { \
+            tag->prop = value; \
+            luaA_object_emit_signal(L, -3, "property::" #prop, 0); \
+        } \
+        return 0; \
+    }
+DO_TAG_SET_NUMBER_PROPERTY(mwfact, double, TAG_DEFAULT_MWFACT)
+DO_TAG_SET_NUMBER_PROPERTY(nmaster, int, TAG_DEFAULT_NMASTER)
+DO_TAG_SET_NUMBER_PROPERTY(ncol, int, TAG_DEFAULT_NCOL)
+#undef DO_TAG_SET_NUMBER_PROPERTY
+
+#define DO_TAG_SET_BOOLEAN_PROPERTY(prop) \
+    static int \
+    luaA_tag_set_##prop(lua_State *L, tag_t *tag) \
+    { \
+        bool value = lua_toboolean(L, -1); \
+        if(tag->prop != value) \
+        { \
+            tag->prop = value; \
+            luaA_object_emit_signal(L, -3, "property::" #prop, 0); \
+        } \
+        return 0; \
+    }
+DO_TAG_SET_BOOLEAN_PROPERTY(hide)
+DO_TAG_SET_BOOLEAN_PROPERTY(icon_only)
+#undef DO_TAG_SET_BOOLEAN_PROPERTY
+
+/** Set the tag layout.
+ * \param L The Lua VM state.
+ * \param tag The tag to set the layout for.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_tag_set_layout(lua_State *L, tag_t *tag)
+{
+    if(lua_topointer(L, -1) == tag->layout && !lua_isnil(L, -1))
+        return 0;
+
+    if(tag->layout)
+        luaA_object_unref_item(L, -3, tag->layout);
+    tag->layout = NULL;
+
+    if(!lua_isnil(L, -1))
+    {
+        /* Reference a copy, luaA_object_ref_item() removes it */
+        lua_pushvalue(L, -1);
+        tag->layout = luaA_object_ref_item(L, -4, -1);
+    }
+
+    luaA_object_emit_signal(L, -3, "property::layout", 0);
+    return 0;
+}
+
+/** Get the tag layout.
+ * \param L The Lua VM state.
+ * \param tag The tag to get the layout for.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_tag_get_layout(lua_State *L, tag_t *tag)
+{
+    if(!tag->layout)
+        return 0;
+    return luaA_object_push_item(L, 1, tag->layout);
+}
 
 /** Set the tag name.
  * \param L The Lua VM state.
@@ -422,7 +622,7 @@ tag_class_setup(lua_State *L)
     };
 
     luaA_class_setup(L, &tag_class, "tag", NULL,
-                     (lua_class_allocator_t) tag_new,
+                     (lua_class_allocator_t) tag_allocator,
                      (lua_class_collector_t) tag_wipe,
                      NULL,
                      luaA_class_index_miss_property, luaA_class_newindex_miss_property,
@@ -440,7 +640,38 @@ tag_class_setup(lua_State *L)
                             (lua_class_propfunc_t) luaA_tag_get_selected,
                             (lua_class_propfunc_t) luaA_tag_set_selected);
 
+    luaA_class_add_property(&tag_class, "mwfact",
+                            (lua_class_propfunc_t) luaA_tag_set_mwfact,
+                            (lua_class_propfunc_t) luaA_tag_get_mwfact,
+                            (lua_class_propfunc_t) luaA_tag_set_mwfact);
+    luaA_class_add_property(&tag_class, "nmaster",
+                            (lua_class_propfunc_t) luaA_tag_set_nmaster,
+                            (lua_class_propfunc_t) luaA_tag_get_nmaster,
+                            (lua_class_propfunc_t) luaA_tag_set_nmaster);
+    luaA_class_add_property(&tag_class, "ncol",
+                            (lua_class_propfunc_t) luaA_tag_set_ncol,
+                            (lua_class_propfunc_t) luaA_tag_get_ncol,
+                            (lua_class_propfunc_t) luaA_tag_set_ncol);
+    luaA_class_add_property(&tag_class, "hide",
+                            (lua_class_propfunc_t) luaA_tag_set_hide,
+                            (lua_class_propfunc_t) luaA_tag_get_hide,
+                            (lua_class_propfunc_t) luaA_tag_set_hide);
+    luaA_class_add_property(&tag_class, "icon_only",
+                            (lua_class_propfunc_t) luaA_tag_set_icon_only,
+                            (lua_class_propfunc_t) luaA_tag_get_icon_only,
+                            (lua_class_propfunc_t) luaA_tag_set_icon_only);
+    luaA_class_add_property(&tag_class, "layout",
+                            (lua_class_propfunc_t) luaA_tag_set_layout,
+                            (lua_class_propfunc_t) luaA_tag_get_layout,
+                            (lua_class_propfunc_t) luaA_tag_set_layout);
+
+    signal_add(&tag_class.signals, "property::hide");
+    signal_add(&tag_class.signals, "property::icon_only");
+    signal_add(&tag_class.signals, "property::layout");
+    signal_add(&tag_class.signals, "property::mwfact");
     signal_add(&tag_class.signals, "property::name");
+    signal_add(&tag_class.signals, "property::ncol");
+    signal_add(&tag_class.signals, "property::nmaster");
     signal_add(&tag_class.signals, "property::screen");
     signal_add(&tag_class.signals, "property::selected");
     signal_add(&tag_class.signals, "tagged");
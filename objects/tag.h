@@ -28,6 +28,7 @@ int tags_get_first_selected_index(screen_t *);
 void tag_client(client_t *);
 void untag_client(client_t *, tag_t *);
 bool is_client_tagged(client_t *, tag_t *);
+void luaA_tag_set_client_tags(lua_State *, client_t *, int);
 void tag_view_only_byindex(screen_t *, int);
 void tag_append_to_screen(lua_State *, int, screen_t *);
 void tag_remove_from_screen(tag_t *);
@@ -39,6 +40,10 @@ void tag_class_setup(lua_State *);
 
 bool tag_get_selected(tag_t *);
 char *tag_get_name(tag_t *);
+double tag_get_mwfact(tag_t *);
+int tag_get_nmaster(tag_t *);
+int tag_get_ncol(tag_t *);
+int tag_get_client_count(tag_t *);
 
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
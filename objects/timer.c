@@ -19,6 +19,15 @@
  *
  */
 
+/* Timers with a slack do not get an ev_timer of their own. They share a
+ * single one, armed for the latest instant at which one of them may fire,
+ * and every timer due by then fires in the same wakeup, so that awesome is
+ * not woken up at unrelated instants and whatever they redraw is refreshed
+ * once. The slack only decides where a timer fires within its window: its
+ * next deadline counts from the previous one, so that it still fires every
+ * timeout on average.
+ */
+
 #include <ev.h>
 
 #include "globalconf.h"
@@ -31,11 +40,146 @@ typedef struct
     LUA_OBJECT_HEADER
     bool started;
     struct ev_timer timer;
+    /** How late the timer may fire to be coalesced with others, 0 for none */
+    double slack;
+    /** When the timer is due, if it has a slack */
+    ev_tstamp deadline;
 } atimer_t;
 
 static lua_class_t timer_class;
 LUA_OBJECT_FUNCS(timer_class, atimer_t, timer)
 
+DO_ARRAY(atimer_t *, atimer, DO_NOTHING)
+
+/** The timers with a slack and their shared watcher */
+static struct
+{
+    atimer_array_t timers;
+    struct ev_timer timer;
+} timer_wheel;
+
+/** Arm the shared watcher for the latest instant the next timer may fire. */
+static void
+timer_wheel_update(void)
+{
+    ev_tstamp next = 0;
+
+    ev_timer_stop(globalconf.loop, &timer_wheel.timer);
+
+    foreach(t, timer_wheel.timers)
+        if(t == timer_wheel.timers.tab || (*t)->deadline + (*t)->slack < next)
+            next = (*t)->deadline + (*t)->slack;
+
+    if(timer_wheel.timers.len)
+    {
+        ev_timer_set(&timer_wheel.timer, MAX(next - ev_now(globalconf.loop), 0), 0);
+        ev_timer_start(globalconf.loop, &timer_wheel.timer);
+    }
+}
+
+static void
+timer_wheel_remove(atimer_t *timer)
+{
+    foreach(t, timer_wheel.timers)
+        if(*t == timer)
+        {
+            atimer_array_remove(&timer_wheel.timers, t);
+            break;
+        }
+}
+
+static void
+ev_timer_wheel_emit_signals(struct ev_loop *loop, struct ev_timer *w, int revents)
+{
+    lua_State *L = globalconf.L;
+    ev_tstamp now = ev_now(loop);
+    int due = 0;
+
+    /* Reschedule every due timer first, and keep them on the stack so that
+     * they stay alive whatever the signal handlers do */
+    for(int i = 0; i < timer_wheel.timers.len;)
+    {
+        atimer_t *timer = timer_wheel.timers.tab[i];
+
+        if(timer->deadline > now)
+        {
+            i++;
+            continue;
+        }
+
+        if(!lua_checkstack(L, 1))
+            break;
+        luaA_object_push(L, timer);
+        due++;
+
+        if(timer->timer.repeat > 0)
+        {
+            ev_tstamp repeat = timer->timer.repeat;
+
+            timer->deadline += repeat;
+            /* Skip the periods missed, e.g. while suspended */
+            if(timer->deadline <= now)
+                timer->deadline += ((int64_t) ((now - timer->deadline) / repeat) + 1) * repeat;
+            i++;
+        }
+        else
+            /* Fire once, like an ev_timer without repeat */
+            atimer_array_take(&timer_wheel.timers, i);
+    }
+
+    timer_wheel_update();
+
+    int base = lua_gettop(L) - due;
+    for(int i = base + 1; i <= base + due; i++)
+    {
+        atimer_t *timer = lua_touserdata(L, i);
+        /* A handler may have stopped it */
+        if(timer->started)
+            luaA_object_emit_signal(L, i, "timeout", 0);
+    }
+
+    lua_pop(L, due);
+}
+
+/** Start or restart a timer.
+ * \param timer The timer.
+ * \param again Restart it like ev_timer_again(), rather than starting it
+ * like ev_timer_start().
+ */
+static void
+timer_schedule(atimer_t *timer, bool again)
+{
+    if(timer->slack > 0)
+    {
+        timer_wheel_remove(timer);
+        if(!again || timer->timer.repeat > 0)
+        {
+            timer->deadline = ev_now(globalconf.loop) + timer->timer.repeat;
+            atimer_array_append(&timer_wheel.timers, timer);
+        }
+        timer_wheel_update();
+    }
+    else if(again)
+        ev_timer_again(globalconf.loop, &timer->timer);
+    else
+        ev_timer_start(globalconf.loop, &timer->timer);
+}
+
+/** Stop a timer.
+ * \param timer The timer.
+ */
+static void
+timer_unschedule(atimer_t *timer)
+{
+    if(timer->slack > 0)
+    {
+        timer_wheel_remove(timer);
+        timer_wheel_update();
+    }
+    else
+        ev_timer_stop(globalconf.loop, &timer->timer);
+}
+
 static void
 ev_timer_emit_signal(struct ev_loop *loop, struct ev_timer *w, int revents)
 {
@@ -70,6 +214,24 @@ luaA_timer_get_timeout(lua_State *L, atimer_t *timer)
     return 1;
 }
 
+static int
+luaA_timer_set_slack(lua_State *L, atimer_t *timer)
+{
+    double slack = luaL_checknumber(L, -1);
+
+    if(slack < 0)
+        luaL_error(L, "timer slack must be positive");
+
+    if(timer->started)
+        timer_unschedule(timer);
+    timer->slack = slack;
+    if(timer->started)
+        timer_schedule(timer, true);
+
+    luaA_object_emit_signal(L, -3, "property::slack", 0);
+    return 0;
+}
+
 static int
 luaA_timer_start(lua_State *L)
 {
@@ -79,7 +241,7 @@ luaA_timer_start(lua_State *L)
     else
     {
         luaA_object_ref(L, 1);
-        ev_timer_start(globalconf.loop, &timer->timer);
+        timer_schedule(timer, false);
         timer->started = true;
     }
     return 0;
@@ -91,7 +253,7 @@ luaA_timer_stop(lua_State *L)
     atimer_t *timer = luaA_checkudata(L, 1, &timer_class);
     if(timer->started)
     {
-        ev_timer_stop(globalconf.loop, &timer->timer);
+        timer_unschedule(timer);
         luaA_object_unref(L, timer);
         timer->started = false;
     }
@@ -105,7 +267,7 @@ luaA_timer_again(lua_State *L)
 {
     atimer_t *timer = luaA_checkudata(L, 1, &timer_class);
 
-    ev_timer_again(globalconf.loop, &timer->timer);
+    timer_schedule(timer, true);
 
     if(!timer->started)
     {
@@ -117,6 +279,7 @@ luaA_timer_again(lua_State *L)
 }
 
 LUA_OBJECT_EXPORT_PROPERTY(timer, atimer_t, started, lua_pushboolean)
+LUA_OBJECT_EXPORT_PROPERTY(timer, atimer_t, slack, lua_pushnumber)
 
 void
 timer_class_setup(lua_State *L)
@@ -151,8 +314,16 @@ timer_class_setup(lua_State *L)
                             (lua_class_propfunc_t) luaA_timer_get_started,
                             NULL);
 
+    luaA_class_add_property(&timer_class, "slack",
+                            (lua_class_propfunc_t) luaA_timer_set_slack,
+                            (lua_class_propfunc_t) luaA_timer_get_slack,
+                            (lua_class_propfunc_t) luaA_timer_set_slack);
+
+    signal_add(&timer_class.signals, "property::slack");
     signal_add(&timer_class.signals, "property::timeout");
     signal_add(&timer_class.signals, "timeout");
+
+    ev_init(&timer_wheel.timer, ev_timer_wheel_emit_signals);
 }
 
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
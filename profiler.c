@@ -0,0 +1,353 @@
+/*
+ * profiler.c - event loop profiler
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#include <xcb/xcb_event.h>
+
+#include "profiler.h"
+#include "globalconf.h"
+#include "luaa.h"
+#include "xtrace.h"
+#include "common/luaobject.h"
+
+/** Default number of iterations kept */
+#define PROFILER_DEFAULT_SIZE 1024
+
+/** What happened during one main loop iteration */
+typedef struct
+{
+    /** When the iteration ended */
+    ev_tstamp timestamp;
+    /** Wall time spent in each phase */
+    ev_tstamp phases[PROFILER_PHASE_COUNT];
+    /** Number of X events handled */
+    uint32_t events;
+    /** Number of X requests sent */
+    uint32_t requests;
+} profiler_sample_t;
+
+/** Accumulated statistics about one X event type */
+typedef struct
+{
+    uint32_t count;
+    ev_tstamp total, max;
+} profiler_event_stat_t;
+
+static const char * const profiler_phase_names[PROFILER_PHASE_COUNT] =
+{
+    [PROFILER_PHASE_DISPATCH] = "dispatch",
+    [PROFILER_PHASE_LUA_REFRESH] = "lua_refresh",
+    [PROFILER_PHASE_BANNING] = "banning",
+    [PROFILER_PHASE_STACK] = "stack",
+    [PROFILER_PHASE_FOCUS] = "focus",
+    [PROFILER_PHASE_FLUSH] = "flush",
+    [PROFILER_PHASE_GC] = "gc",
+};
+
+bool profiler_enabled = false;
+
+static struct
+{
+    /** Ring buffer of the last iterations */
+    profiler_sample_t *samples;
+    /** Capacity of the ring buffer, number of valid entries and next slot */
+    int size, len, next;
+    /** The iteration being recorded */
+    profiler_sample_t current;
+    /** Start of the phase being timed */
+    ev_tstamp mark;
+    /** Sequence number of the request ending the previous iteration */
+    unsigned int sequence;
+    /** Statistics by event response type */
+    profiler_event_stat_t events[256];
+} profiler;
+
+/** Remember the current time as the start of a phase.
+ */
+void
+profiler_record_begin(void)
+{
+    profiler.mark = ev_time();
+}
+
+/** Account the time elapsed since the last mark to a phase.
+ * \param phase The phase.
+ */
+void
+profiler_record_phase(profiler_phase_t phase)
+{
+    ev_tstamp now = ev_time();
+    profiler.current.phases[phase] += now - profiler.mark;
+    profiler.mark = now;
+}
+
+/** Record the handling of one X event.
+ * \param type The event response type.
+ * \param duration The time it took to handle it.
+ */
+void
+profiler_record_event(uint8_t type, ev_tstamp duration)
+{
+    profiler_event_stat_t *stat = &profiler.events[type];
+
+    profiler.current.events++;
+    stat->count++;
+    stat->total += duration;
+    if(duration > stat->max)
+        stat->max = duration;
+}
+
+/** Store the iteration recorded so far in the ring buffer and start a new one.
+ * This sends a NoOperation request to learn how many requests were issued.
+ */
+void
+profiler_record_iteration(void)
+{
+    unsigned int sequence;
+
+    if(!profiler_enabled)
+        return;
+
+    sequence = xcb_no_operation(globalconf.connection).sequence;
+    profiler.current.requests = sequence - profiler.sequence - 1;
+    profiler.current.timestamp = ev_now(globalconf.loop);
+    profiler.sequence = sequence;
+
+    profiler.samples[profiler.next] = profiler.current;
+    profiler.next = (profiler.next + 1) % profiler.size;
+    if(profiler.len < profiler.size)
+        profiler.len++;
+
+    p_clear(&profiler.current, 1);
+}
+
+/** Forget everything recorded so far.
+ */
+static void
+profiler_reset(void)
+{
+    profiler.len = profiler.next = 0;
+    p_clear(&profiler.current, 1);
+    p_clear(profiler.events, countof(profiler.events));
+    if(profiler_enabled)
+        profiler.sequence = xcb_no_operation(globalconf.connection).sequence;
+}
+
+/** Start recording.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam The number of iterations to keep, defaults to 1024.
+ */
+static int
+luaA_profiler_start(lua_State *L)
+{
+    int size = luaL_optnumber(L, 1, PROFILER_DEFAULT_SIZE);
+
+    if(size <= 0)
+        luaL_error(L, "invalid size");
+
+    if(size != profiler.size)
+    {
+        p_delete(&profiler.samples);
+        profiler.samples = p_new(profiler_sample_t, size);
+        profiler.size = size;
+    }
+
+    profiler_enabled = true;
+    profiler_reset();
+    return 0;
+}
+
+/** Stop recording. The data recorded so far stays available.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_profiler_stop(lua_State *L)
+{
+    profiler_enabled = false;
+    return 0;
+}
+
+/** Forget everything recorded so far, including signal handler costs and
+ * X request counts.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_profiler_reset(lua_State *L)
+{
+    profiler_reset();
+    signal_profiler_reset();
+    xtrace_reset();
+    return 0;
+}
+
+/** Start accounting the cost of Lua signal handlers.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_profiler_start_signals(lua_State *L)
+{
+    signal_profiler_enabled = true;
+    return 0;
+}
+
+/** Stop accounting the cost of Lua signal handlers.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_profiler_stop_signals(lua_State *L)
+{
+    signal_profiler_enabled = false;
+    return 0;
+}
+
+/** Get the cost of the Lua signal handlers.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lreturn A table of tables with the signal, source, calls, time, max and
+ * memory fields.
+ */
+static int
+luaA_profiler_signals(lua_State *L)
+{
+    signal_profiler_push(L);
+    return 1;
+}
+
+/** Check whether the profiler is recording.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lreturn True if recording.
+ */
+static int
+luaA_profiler_running(lua_State *L)
+{
+    lua_pushboolean(L, profiler_enabled);
+    return 1;
+}
+
+/** Get the recorded main loop iterations, oldest first.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lreturn A table of iterations, each a table with timestamp, events,
+ * requests, total and a time table with the duration of each phase.
+ */
+static int
+luaA_profiler_samples(lua_State *L)
+{
+    /* Until the ring buffer wraps, the oldest entry is the first one */
+    int first = profiler.len < profiler.size ? 0 : profiler.next;
+
+    lua_createtable(L, profiler.len, 0);
+    for(int i = 0; i < profiler.len; i++)
+    {
+        profiler_sample_t *sample = &profiler.samples[(first + i) % profiler.size];
+        ev_tstamp total = 0;
+
+        lua_createtable(L, 0, 5);
+        lua_pushnumber(L, sample->timestamp);
+        lua_setfield(L, -2, "timestamp");
+        lua_pushnumber(L, sample->events);
+        lua_setfield(L, -2, "events");
+        lua_pushnumber(L, sample->requests);
+        lua_setfield(L, -2, "requests");
+
+        lua_createtable(L, 0, PROFILER_PHASE_COUNT);
+        for(int phase = 0; phase < PROFILER_PHASE_COUNT; phase++)
+        {
+            lua_pushnumber(L, sample->phases[phase]);
+            lua_setfield(L, -2, profiler_phase_names[phase]);
+            total += sample->phases[phase];
+        }
+        lua_setfield(L, -2, "time");
+
+        lua_pushnumber(L, total);
+        lua_setfield(L, -2, "total");
+
+        lua_rawseti(L, -2, i + 1);
+    }
+
+    return 1;
+}
+
+/** Get the statistics about handled X events.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lreturn A table indexed by event name (or response type for extension
+ * events) of tables with count, total and max time.
+ */
+static int
+luaA_profiler_events(lua_State *L)
+{
+    lua_newtable(L);
+    for(int type = 0; type < countof(profiler.events); type++)
+    {
+        profiler_event_stat_t *stat = &profiler.events[type];
+        const char *label;
+
+        if(!stat->count)
+            continue;
+
+        if((label = xcb_event_get_label(type)))
+            lua_pushstring(L, label);
+        else
+            lua_pushnumber(L, type);
+
+        lua_createtable(L, 0, 3);
+        lua_pushnumber(L, stat->count);
+        lua_setfield(L, -2, "count");
+        lua_pushnumber(L, stat->total);
+        lua_setfield(L, -2, "total");
+        lua_pushnumber(L, stat->max);
+        lua_setfield(L, -2, "max");
+
+        lua_rawset(L, -3);
+    }
+
+    return 1;
+}
+
+const struct luaL_Reg awesome_profiler_lib[] =
+{
+    { "start", luaA_profiler_start },
+    { "stop", luaA_profiler_stop },
+    { "reset", luaA_profiler_reset },
+    { "running", luaA_profiler_running },
+    { "samples", luaA_profiler_samples },
+    { "events", luaA_profiler_events },
+    { "start_signals", luaA_profiler_start_signals },
+    { "stop_signals", luaA_profiler_stop_signals },
+    { "signals", luaA_profiler_signals },
+    { "start_xcb", luaA_xtrace_start },
+    { "stop_xcb", luaA_xtrace_stop },
+    { "xcb_sites", luaA_xtrace_sites },
+    { "xcb_requests", luaA_xtrace_requests },
+    { NULL, NULL }
+};
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,69 @@
+/*
+ * profiler.h - event loop profiler header
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef AWESOME_PROFILER_H
+#define AWESOME_PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <ev.h>
+
+/** The phases of a main loop iteration */
+typedef enum
+{
+    PROFILER_PHASE_DISPATCH,
+    PROFILER_PHASE_LUA_REFRESH,
+    PROFILER_PHASE_BANNING,
+    PROFILER_PHASE_STACK,
+    PROFILER_PHASE_FOCUS,
+    PROFILER_PHASE_FLUSH,
+    PROFILER_PHASE_GC,
+    PROFILER_PHASE_COUNT
+} profiler_phase_t;
+
+/** Whether the profiler is recording */
+extern bool profiler_enabled;
+
+void profiler_record_begin(void);
+void profiler_record_phase(profiler_phase_t);
+void profiler_record_event(uint8_t, ev_tstamp);
+void profiler_record_iteration(void);
+
+/** Start timing a phase.
+ */
+static inline void
+profiler_begin(void)
+{
+    if(profiler_enabled)
+        profiler_record_begin();
+}
+
+/** Account the time since the last mark to a phase.
+ * \param phase The phase which just ended.
+ */
+static inline void
+profiler_mark(profiler_phase_t phase)
+{
+    if(profiler_enabled)
+        profiler_record_phase(phase);
+}
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -111,6 +111,9 @@ property_update_wm_transient_for(client_t *c, xcb_get_property_cookie_t cookie)
 					     &trans, NULL))
             return;
 
+    c->has_transient_for = true;
+    c->transient_for_window = trans;
+
     luaA_object_push(globalconf.L, c);
     client_set_type(globalconf.L, -1, WINDOW_TYPE_DIALOG);
     client_set_above(globalconf.L, -1, false);
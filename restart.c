@@ -0,0 +1,722 @@
+/*
+ * restart.c - restart state handoff
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* On restart, the new instance used to fetch every property and icon of
+ * every window again, and could only put clients back on the tag recorded in
+ * _NET_WM_DESKTOP. Instead, the state of each client is written to an
+ * anonymous file right before exec, and the file descriptor is passed in the
+ * environment. The new instance reads it back before loading its
+ * configuration and restores each client from it when managing it at
+ * startup. Clients it does not know about are managed as usual.
+ *
+ * Properties changing during the restart are not missed: the new instance
+ * selects property changes on the saved windows as soon as it owns the
+ * screen, and handles the resulting events once the clients are managed.
+ * Only changes made between the save and that point would be lost, until
+ * the property changes again.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "config.h"
+#include "restart.h"
+#include "globalconf.h"
+#include "luaa.h"
+#include "screen.h"
+#include "objects/tag.h"
+#include "common/buffer.h"
+
+#define RESTART_ENV "AWESOME_RESTART_FD"
+#define RESTART_MAGIC "AWRS"
+/** Bump this whenever the format below changes */
+#define RESTART_VERSION 2
+
+/** Client flags */
+#define RESTART_URGENT            (1 << 0)
+#define RESTART_NOFOCUS           (1 << 1)
+#define RESTART_SIZE_HINTS_HONOR  (1 << 2)
+/** WM_TRANSIENT_FOR is set, whether or not it points to a client */
+#define RESTART_TRANSIENT         (1 << 3)
+#define RESTART_ICON              (1 << 4)
+
+/** The state of a client, pointing into the loaded file */
+typedef struct
+{
+    xcb_window_t window;
+    area_t geometry;
+    uint16_t border_width;
+    uint32_t flags;
+    const char *name, *alt_name, *icon_name, *alt_icon_name;
+    const char *class, *instance, *role, *machine;
+    uint32_t pid;
+    xcb_window_t transient_for, leader_window, group_window;
+    xcb_size_hints_t size_hints;
+    double opacity;
+    strut_t strut;
+    uint32_t protocols_len;
+    const char *protocols;
+    uint16_t icon_width, icon_height;
+    const char *icon;
+    uint32_t tags_len;
+    const char *tags;
+} restart_client_t;
+
+static int
+restart_client_cmp(const void *a, const void *b)
+{
+    const restart_client_t *x = a, *y = b;
+    return x->window > y->window ? 1 : (x->window < y->window ? -1 : 0);
+}
+
+DO_BARRAY(restart_client_t, restart_client, DO_NOTHING, restart_client_cmp)
+
+/** A string handed over by Lua, keyed by its owner so that several modules
+ * can hand over their own state */
+typedef struct
+{
+    char *owner;
+    char *state;
+    uint32_t len;
+} restart_lua_state_t;
+
+static void
+restart_lua_state_wipe(restart_lua_state_t *s)
+{
+    p_delete(&s->owner);
+    p_delete(&s->state);
+}
+
+DO_ARRAY(restart_lua_state_t, restart_lua_state, restart_lua_state_wipe)
+
+static struct
+{
+    /** The file written by the previous instance */
+    char *data;
+    /** The clients it describes, not yet restored */
+    restart_client_array_t clients;
+    /** The Lua states it handed over */
+    restart_lua_state_array_t lua_states;
+    /** The Lua states to hand over to the next instance */
+    restart_lua_state_array_t next_lua_states;
+} restart;
+
+/** Find the Lua state of an owner.
+ * \param states The states to look into.
+ * \param owner The owner.
+ * \return The state, or NULL.
+ */
+static restart_lua_state_t *
+restart_lua_state_lookup(restart_lua_state_array_t *states, const char *owner)
+{
+    foreach(s, *states)
+        if(A_STREQ(s->owner, owner))
+            return s;
+    return NULL;
+}
+
+/* {{{ Saving */
+
+static void
+restart_put_u32(buffer_t *buf, uint32_t value)
+{
+    buffer_add(buf, &value, sizeof(value));
+}
+
+static void
+restart_put_string(buffer_t *buf, const char *s)
+{
+    if(!s)
+        restart_put_u32(buf, 0);
+    else
+    {
+        /* Keep the NUL, so that the string can be used in place */
+        uint32_t len = a_strlen(s) + 1;
+        restart_put_u32(buf, len);
+        buffer_add(buf, s, len);
+    }
+}
+
+/** Append the state of a client.
+ * \param buf The buffer to append to.
+ * \param c The client.
+ */
+static void
+restart_put_client(buffer_t *buf, client_t *c)
+{
+    uint32_t flags = 0;
+    int len_pos;
+
+    if(c->urgent)
+        flags |= RESTART_URGENT;
+    if(c->nofocus)
+        flags |= RESTART_NOFOCUS;
+    if(c->size_hints_honor)
+        flags |= RESTART_SIZE_HINTS_HONOR;
+    if(c->has_transient_for)
+        flags |= RESTART_TRANSIENT;
+    if(c->icon && cairo_image_surface_get_format(c->icon) == CAIRO_FORMAT_ARGB32)
+        flags |= RESTART_ICON;
+
+    restart_put_u32(buf, c->window);
+    /* Length of the record, filled in below */
+    len_pos = buf->len;
+    restart_put_u32(buf, 0);
+
+    buffer_add(buf, &c->geometry, sizeof(c->geometry));
+    buffer_add(buf, &c->border_width, sizeof(c->border_width));
+    restart_put_u32(buf, flags);
+    restart_put_string(buf, c->name);
+    restart_put_string(buf, c->alt_name);
+    restart_put_string(buf, c->icon_name);
+    restart_put_string(buf, c->alt_icon_name);
+    restart_put_string(buf, c->class);
+    restart_put_string(buf, c->instance);
+    restart_put_string(buf, c->role);
+    restart_put_string(buf, c->machine);
+    restart_put_u32(buf, c->pid);
+    restart_put_u32(buf, c->transient_for_window);
+    restart_put_u32(buf, c->leader_window);
+    restart_put_u32(buf, c->group_window);
+    buffer_add(buf, &c->size_hints, sizeof(c->size_hints));
+    buffer_add(buf, &c->opacity, sizeof(c->opacity));
+    buffer_add(buf, &c->strut, sizeof(c->strut));
+
+    restart_put_u32(buf, c->protocols.atoms_len);
+    buffer_add(buf, c->protocols.atoms, c->protocols.atoms_len * sizeof(xcb_atom_t));
+
+    if(flags & RESTART_ICON)
+    {
+        uint16_t width = cairo_image_surface_get_width(c->icon);
+        uint16_t height = cairo_image_surface_get_height(c->icon);
+        int stride = cairo_image_surface_get_stride(c->icon);
+        const char *data;
+
+        cairo_surface_flush(c->icon);
+        data = (const char *) cairo_image_surface_get_data(c->icon);
+        buffer_add(buf, &width, sizeof(width));
+        buffer_add(buf, &height, sizeof(height));
+        for(int y = 0; y < height; y++)
+            buffer_add(buf, data + y * stride, width * 4);
+    }
+
+    /* Tags, as screen and tag indexes */
+    int tags_pos = buf->len;
+    uint32_t tags_len = 0;
+    restart_put_u32(buf, 0);
+    foreach(screen, globalconf.screens)
+        foreach(tag, screen->tags)
+            if(is_client_tagged(c, *tag))
+            {
+                restart_put_u32(buf, screen_array_indexof(&globalconf.screens, screen));
+                restart_put_u32(buf, tag_array_indexof(&screen->tags, tag));
+                tags_len++;
+            }
+    memcpy(buf->s + tags_pos, &tags_len, sizeof(tags_len));
+
+    uint32_t len = buf->len - len_pos - sizeof(uint32_t);
+    memcpy(buf->s + len_pos, &len, sizeof(len));
+}
+
+/** Write the state of all clients to an anonymous file and pass it to the
+ * next instance through the environment. This must be called before
+ * closing Lua and after the exit signal, which lets Lua hand over its own
+ * states with awesome.restart_state().
+ */
+void
+restart_save(void)
+{
+    buffer_t buf;
+    int fd;
+
+    buffer_init(&buf);
+    buffer_addsl(&buf, RESTART_MAGIC);
+    restart_put_u32(&buf, RESTART_VERSION);
+    restart_put_u32(&buf, restart.next_lua_states.len);
+    foreach(s, restart.next_lua_states)
+    {
+        restart_put_string(&buf, s->owner);
+        restart_put_u32(&buf, s->len);
+        buffer_add(&buf, s->state, s->len);
+    }
+    restart_put_u32(&buf, globalconf.clients.len);
+    foreach(c, globalconf.clients)
+        restart_put_client(&buf, *c);
+
+#ifdef HAS_MEMFD_CREATE
+    fd = memfd_create("awesome-restart", 0);
+#else
+    FILE *f = tmpfile();
+    fd = f ? fileno(f) : -1;
+#endif
+
+    if(fd < 0)
+    {
+        warn("cannot save the state for the restart: %s", strerror(errno));
+        buffer_wipe(&buf);
+        return;
+    }
+
+    for(int done = 0; done < buf.len;)
+    {
+        ssize_t written = write(fd, buf.s + done, buf.len - done);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            warn("cannot save the state for the restart: %s", strerror(errno));
+            close(fd);
+            buffer_wipe(&buf);
+            return;
+        }
+        done += written;
+    }
+    buffer_wipe(&buf);
+
+    char fd_string[16];
+    snprintf(fd_string, sizeof(fd_string), "%d", fd);
+    setenv(RESTART_ENV, fd_string, 1);
+}
+
+/* }}} */
+
+/* {{{ Loading */
+
+typedef struct
+{
+    const char *p, *end;
+} restart_reader_t;
+
+static bool
+restart_get(restart_reader_t *r, void *out, size_t len)
+{
+    if((size_t) (r->end - r->p) < len)
+        return false;
+    memcpy(out, r->p, len);
+    r->p += len;
+    return true;
+}
+
+/** Get a pointer to some data and skip it.
+ * \param r The reader.
+ * \param out Where to store the pointer.
+ * \param len The length of the data.
+ * \return True if there was enough data.
+ */
+static bool
+restart_get_data(restart_reader_t *r, const char **out, size_t len)
+{
+    if((size_t) (r->end - r->p) < len)
+        return false;
+    *out = r->p;
+    r->p += len;
+    return true;
+}
+
+static bool
+restart_get_string(restart_reader_t *r, const char **out)
+{
+    uint32_t len;
+
+    if(!restart_get(r, &len, sizeof(len)))
+        return false;
+    if(!len)
+    {
+        *out = NULL;
+        return true;
+    }
+    return restart_get_data(r, out, len) && (*out)[len - 1] == '\0';
+}
+
+/** Parse the state of a client.
+ * \param r The reader, limited to the client record.
+ * \param c The client state to fill.
+ * \return True if the record is valid.
+ */
+static bool
+restart_get_client(restart_reader_t *r, restart_client_t *c)
+{
+    if(!(restart_get(r, &c->geometry, sizeof(c->geometry))
+         && restart_get(r, &c->border_width, sizeof(c->border_width))
+         && restart_get(r, &c->flags, sizeof(c->flags))
+         && restart_get_string(r, &c->name)
+         && restart_get_string(r, &c->alt_name)
+         && restart_get_string(r, &c->icon_name)
+         && restart_get_string(r, &c->alt_icon_name)
+         && restart_get_string(r, &c->class)
+         && restart_get_string(r, &c->instance)
+         && restart_get_string(r, &c->role)
+         && restart_get_string(r, &c->machine)
+         && restart_get(r, &c->pid, sizeof(c->pid))
+         && restart_get(r, &c->transient_for, sizeof(c->transient_for))
+         && restart_get(r, &c->leader_window, sizeof(c->leader_window))
+         && restart_get(r, &c->group_window, sizeof(c->group_window))
+         && restart_get(r, &c->size_hints, sizeof(c->size_hints))
+         && restart_get(r, &c->opacity, sizeof(c->opacity))
+         && restart_get(r, &c->strut, sizeof(c->strut))
+         && restart_get(r, &c->protocols_len, sizeof(c->protocols_len))
+         && restart_get_data(r, &c->protocols, c->protocols_len * sizeof(xcb_atom_t))))
+        return false;
+
+    if(c->flags & RESTART_ICON
+       && !(restart_get(r, &c->icon_width, sizeof(c->icon_width))
+            && restart_get(r, &c->icon_height, sizeof(c->icon_height))
+            && restart_get_data(r, &c->icon, (size_t) c->icon_width * c->icon_height * 4)))
+        return false;
+
+    return restart_get(r, &c->tags_len, sizeof(c->tags_len))
+        && restart_get_data(r, &c->tags, c->tags_len * 2 * sizeof(uint32_t))
+        && r->p == r->end;
+}
+
+/** Parse the whole file written by restart_save().
+ * \param len The length of restart.data.
+ * \return True if it is valid.
+ */
+static bool
+restart_parse(size_t len)
+{
+    restart_reader_t r = { .p = restart.data, .end = restart.data + len };
+    const char *magic;
+    uint32_t version, count;
+
+    if(!restart_get_data(&r, &magic, sizeof(RESTART_MAGIC) - 1)
+       || memcmp(magic, RESTART_MAGIC, sizeof(RESTART_MAGIC) - 1)
+       || !restart_get(&r, &version, sizeof(version))
+       || version != RESTART_VERSION
+       || !restart_get(&r, &count, sizeof(count)))
+        return false;
+
+    while(count--)
+    {
+        const char *owner, *state;
+        uint32_t state_len;
+
+        if(!restart_get_string(&r, &owner) || !owner
+           || !restart_get(&r, &state_len, sizeof(state_len))
+           || !restart_get_data(&r, &state, state_len))
+            return false;
+
+        restart_lua_state_array_append(&restart.lua_states,
+                                       (restart_lua_state_t) {
+                                           .owner = a_strdup(owner),
+                                           .state = p_dup(state, state_len),
+                                           .len = state_len
+                                       });
+    }
+
+    if(!restart_get(&r, &count, sizeof(count)))
+        return false;
+
+    while(count--)
+    {
+        restart_client_t c;
+        uint32_t record_len;
+
+        p_clear(&c, 1);
+        if(!restart_get(&r, &c.window, sizeof(c.window))
+           || !restart_get(&r, &record_len, sizeof(record_len))
+           || (size_t) (r.end - r.p) < record_len)
+            return false;
+
+        restart_reader_t record = { .p = r.p, .end = r.p + record_len };
+        if(!restart_get_client(&record, &c))
+            return false;
+        r.p = record.end;
+
+        restart_client_array_insert(&restart.clients, c);
+    }
+
+    return r.p == r.end;
+}
+
+/** Read the state handed over by the previous instance, if any.
+ */
+void
+restart_load(void)
+{
+    const char *env = getenv(RESTART_ENV);
+    struct stat st;
+    ssize_t done = 0;
+    int fd;
+
+    if(!env)
+        return;
+
+    fd = atoi(env);
+    /* Do not pass the state on to our children */
+    unsetenv(RESTART_ENV);
+
+    if(fd < 0 || fstat(fd, &st) || st.st_size <= 0)
+    {
+        warn("cannot read the state of the previous instance");
+        return;
+    }
+
+    restart.data = p_new(char, st.st_size);
+    while(done < st.st_size)
+    {
+        ssize_t n = pread(fd, restart.data + done, st.st_size - done, done);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0)
+            break;
+        done += n;
+    }
+    close(fd);
+
+    if(done != st.st_size || !restart_parse(st.st_size))
+    {
+        warn("ignoring invalid state of the previous instance");
+        restart_wipe();
+    }
+}
+
+/** Select property changes on the windows of the saved clients, so that the
+ * properties changing until they are managed again are fetched then. Call
+ * this as soon as we are the window manager.
+ */
+void
+restart_watch(void)
+{
+    const uint32_t select_input_val[] = { XCB_EVENT_MASK_PROPERTY_CHANGE };
+
+    foreach(c, restart.clients)
+        xcb_change_window_attributes(globalconf.connection, c->window,
+                                     XCB_CW_EVENT_MASK, select_input_val);
+}
+
+/** Forget the state handed over by the previous instance. */
+void
+restart_wipe(void)
+{
+    restart_client_array_wipe(&restart.clients);
+    restart_lua_state_array_wipe(&restart.lua_states);
+    p_delete(&restart.data);
+}
+
+/* }}} */
+
+/* {{{ Restoring */
+
+static restart_client_t *
+restart_client_lookup(xcb_window_t window)
+{
+    restart_client_t key = { .window = window };
+    return restart_client_array_lookup(&restart.clients, &key);
+}
+
+/** Get the geometry a client had in the previous instance.
+ * \param window The client window.
+ * \param geometry The geometry to fill, including the border width.
+ * \return True if the window was a client of the previous instance.
+ */
+bool
+restart_client_geometry(xcb_window_t window, xcb_get_geometry_reply_t *geometry)
+{
+    restart_client_t *saved = restart_client_lookup(window);
+
+    if(!saved)
+        return false;
+
+    geometry->x = saved->geometry.x;
+    geometry->y = saved->geometry.y;
+    geometry->width = saved->geometry.width;
+    geometry->height = saved->geometry.height;
+    geometry->border_width = saved->border_width;
+    return true;
+}
+
+/** Restore the properties of a client as the previous instance fetched
+ * them, instead of client_update_properties().
+ * \param c The client being managed, on top of the Lua stack.
+ * \return False if the client was unknown to the previous instance.
+ */
+bool
+restart_client_restore(client_t *c)
+{
+    restart_client_t *saved = restart_client_lookup(c->window);
+    lua_State *L = globalconf.L;
+
+    if(!saved)
+        return false;
+
+    c->size_hints = saved->size_hints;
+    c->leader_window = saved->leader_window;
+    c->nofocus = saved->flags & RESTART_NOFOCUS;
+    c->size_hints_honor = saved->flags & RESTART_SIZE_HINTS_HONOR;
+    luaA_object_emit_signal(L, -1, "property::size_hints_honor", 0);
+
+    if(strut_has_value(&saved->strut))
+    {
+        c->strut = saved->strut;
+        luaA_object_emit_signal(L, -1, "property::struts", 0);
+    }
+
+    client_set_urgent(L, -1, saved->flags & RESTART_URGENT);
+    if(saved->group_window)
+        client_set_group_window(L, -1, saved->group_window);
+    /* Like property_update_wm_transient_for(), whether or not the window it
+     * points to is a client */
+    if(saved->flags & RESTART_TRANSIENT)
+    {
+        c->has_transient_for = true;
+        c->transient_for_window = saved->transient_for;
+        client_set_type(L, -1, WINDOW_TYPE_DIALOG);
+        client_set_above(L, -1, false);
+        client_set_transient_for(L, -1, client_getbywin(saved->transient_for));
+    }
+    if(saved->machine)
+        client_set_machine(L, -1, a_strdup(saved->machine));
+    if(saved->role)
+        client_set_role(L, -1, a_strdup(saved->role));
+    if(saved->pid)
+        client_set_pid(L, -1, saved->pid);
+
+    if(saved->flags & RESTART_ICON)
+    {
+        cairo_surface_t *icon = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
+                                                           saved->icon_width,
+                                                           saved->icon_height);
+        unsigned char *data = cairo_image_surface_get_data(icon);
+        int stride = cairo_image_surface_get_stride(icon);
+
+        cairo_surface_flush(icon);
+        for(int y = 0; y < saved->icon_height; y++)
+            memcpy(data + y * stride, saved->icon + (size_t) y * saved->icon_width * 4,
+                   saved->icon_width * 4);
+        cairo_surface_mark_dirty(icon);
+        client_set_icon(c, icon);
+        cairo_surface_destroy(icon);
+    }
+
+    client_set_alt_name(L, -1, a_strdup(saved->alt_name));
+    client_set_name(L, -1, a_strdup(saved->name));
+    client_set_alt_icon_name(L, -1, a_strdup(saved->alt_icon_name));
+    client_set_icon_name(L, -1, a_strdup(saved->icon_name));
+    if(saved->class || saved->instance)
+        client_set_class_instance(L, -1, saved->class, saved->instance);
+
+    /* Build a reply like xcb_icccm_get_wm_protocols_reply() does, so that
+     * xcb_icccm_get_wm_protocols_reply_wipe() can free it */
+    xcb_icccm_get_wm_protocols_reply_wipe(&c->protocols);
+    c->protocols._reply = (xcb_get_property_reply_t *)
+        p_new(char, sizeof(xcb_get_property_reply_t) + saved->protocols_len * sizeof(xcb_atom_t));
+    c->protocols.atoms_len = saved->protocols_len;
+    c->protocols.atoms = (xcb_atom_t *) (c->protocols._reply + 1);
+    memcpy(c->protocols.atoms, saved->protocols, saved->protocols_len * sizeof(xcb_atom_t));
+
+    window_set_opacity(L, -1, saved->opacity);
+
+    return true;
+}
+
+/** Put a client back on the tags it had in the previous instance, instead of
+ * the one from _NET_WM_DESKTOP, and forget its saved state.
+ * \param c The client being managed.
+ */
+void
+restart_client_restore_tags(client_t *c)
+{
+    restart_client_t *saved = restart_client_lookup(c->window);
+
+    if(!saved)
+        return;
+
+    if(saved->tags_len)
+        foreach(screen, globalconf.screens)
+            for(int i = 0; i < screen->tags.len; i++)
+            {
+                uint32_t screen_index = screen_array_indexof(&globalconf.screens, screen);
+                bool tagged = false;
+
+                for(uint32_t k = 0; k < saved->tags_len && !tagged; k++)
+                {
+                    uint32_t pair[2];
+                    memcpy(pair, saved->tags + k * sizeof(pair), sizeof(pair));
+                    tagged = pair[0] == screen_index && pair[1] == (uint32_t) i;
+                }
+
+                if(tagged)
+                {
+                    luaA_object_push(globalconf.L, screen->tags.tab[i]);
+                    tag_client(c);
+                }
+                else
+                    untag_client(c, screen->tags.tab[i]);
+            }
+
+    restart_client_array_remove(&restart.clients, saved);
+}
+
+/* }}} */
+
+/** Get or set the Lua state of an owner handed over on restart.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lparam The owner of the state, like the name of the module saving it.
+ * \lparam An optional string to hand over to the next instance if awesome
+ * restarts, nil to hand nothing over.
+ * \lreturn With only the owner, the string the previous instance handed over
+ * for it, or nil. It is only available until the existing clients are managed.
+ */
+int
+luaA_restart_state(lua_State *L)
+{
+    const char *owner = luaL_checkstring(L, 1);
+    restart_lua_state_t *s;
+
+    luaL_argcheck(L, *owner, 1, "empty owner");
+
+    if(lua_gettop(L) == 1)
+    {
+        if(!(s = restart_lua_state_lookup(&restart.lua_states, owner)))
+            return 0;
+        lua_pushlstring(L, s->state, s->len);
+        return 1;
+    }
+
+    size_t len;
+    const char *state = luaL_optlstring(L, 2, NULL, &len);
+
+    if((s = restart_lua_state_lookup(&restart.next_lua_states, owner)))
+    {
+        restart_lua_state_t old = restart_lua_state_array_remove(&restart.next_lua_states, s);
+        restart_lua_state_wipe(&old);
+    }
+    if(state)
+        restart_lua_state_array_append(&restart.next_lua_states,
+                                       (restart_lua_state_t) {
+                                           .owner = a_strdup(owner),
+                                           .state = p_dup(state, len),
+                                           .len = len
+                                       });
+    return 0;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -351,6 +351,8 @@ screen_client_moveto(client_t *c, screen_t *new_screen, bool doresize)
         had_focus = true;
 
     c->screen = new_screen;
+    spatial_need_update(old_screen);
+    spatial_need_update(new_screen);
 
     /* If client was on a screen, remove old tags */
     if(old_screen)
@@ -24,6 +24,8 @@
 
 #include "globalconf.h"
 #include "draw.h"
+#include "spatial.h"
+#include "common/bitset.h"
 
 typedef struct screen_output_t screen_output_t;
 ARRAY_TYPE(screen_output_t, screen_output)
@@ -34,10 +36,14 @@ struct a_screen
     area_t geometry;
     /** Tag list */
     tag_array_t tags;
+    /** Slots of the selected tags */
+    bitset_t selected_tags;
     /** The signals emitted by screen objects */
     signal_array_t signals;
     /** The screen outputs informations */
     screen_output_array_t outputs;
+    /** Index of the clients on this screen by position */
+    spatial_index_t spatial;
 };
 ARRAY_FUNCS(screen_t, screen, DO_NOTHING)
 
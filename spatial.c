@@ -0,0 +1,177 @@
+/*
+ * spatial.c - spatial index of client frames
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <stdlib.h>
+
+#include "spatial.h"
+#include "screen.h"
+#include "objects/client.h"
+
+static int
+spatial_cmp_x(const void *a, const void *b)
+{
+    const client_t *x = *(client_t * const *) a, *y = *(client_t * const *) b;
+    return x->geometry.x - y->geometry.x;
+}
+
+static int
+spatial_cmp_y(const void *a, const void *b)
+{
+    const client_t *x = *(client_t * const *) a, *y = *(client_t * const *) b;
+    return x->geometry.y - y->geometry.y;
+}
+
+/** Mark the index of a screen as outdated.
+ * The index is rebuilt lazily on the next query, so a burst of resizes only
+ * costs one sort.
+ * \param s The screen, may be NULL.
+ */
+void
+spatial_need_update(screen_t *s)
+{
+    if(s)
+        s->spatial.need_update = true;
+}
+
+/** Rebuild the index of a screen if needed.
+ * \param s The screen.
+ */
+static void
+spatial_refresh(screen_t *s)
+{
+    spatial_index_t *idx = &s->spatial;
+
+    if(!idx->need_update)
+        return;
+
+    idx->need_update = false;
+    idx->byx.len = idx->byy.len = 0;
+    idx->max_width = idx->max_height = 0;
+
+    foreach(c, globalconf.clients)
+        if((*c)->screen == s)
+        {
+            client_array_append(&idx->byx, *c);
+            client_array_append(&idx->byy, *c);
+            idx->max_width = MAX(idx->max_width, (*c)->geometry.width);
+            idx->max_height = MAX(idx->max_height, (*c)->geometry.height);
+        }
+
+    qsort(idx->byx.tab, idx->byx.len, sizeof(client_t *), spatial_cmp_x);
+    qsort(idx->byy.tab, idx->byy.len, sizeof(client_t *), spatial_cmp_y);
+}
+
+/** Find the first element of a sorted array whose key is above a value.
+ * \param arr The array, sorted along the axis.
+ * \param vertical Use the y axis instead of x.
+ * \param value The value to compare with.
+ * \return The index of the first element whose key is strictly greater.
+ */
+static int
+spatial_upper_bound(client_array_t *arr, bool vertical, int value)
+{
+    int l = 0, r = arr->len;
+
+    while(l < r)
+    {
+        int i = (l + r) / 2;
+        int key = vertical ? arr->tab[i]->geometry.y : arr->tab[i]->geometry.x;
+        if(key <= value)
+            l = i + 1;
+        else
+            r = i;
+    }
+
+    return l;
+}
+
+/** Find the nearest visible client in a direction.
+ * Client A is considered before client B when B's origin lies strictly in
+ * the given direction of A's origin. The distance is measured from the
+ * border of A facing the direction to the opposite border of B.
+ * \param sel The client to start from.
+ * \param dir The direction.
+ * \return The nearest client, or NULL if there is none.
+ */
+client_t *
+spatial_find_in_direction(client_t *sel, spatial_direction_t dir)
+{
+    screen_t *s = sel->screen;
+    bool vertical = (dir == SPATIAL_UP || dir == SPATIAL_DOWN);
+    bool forward = (dir == SPATIAL_DOWN || dir == SPATIAL_RIGHT);
+    area_t ga = sel->geometry;
+    client_t *target = NULL;
+    int64_t dist_min = 0;
+
+    if(!s)
+        return NULL;
+
+    spatial_refresh(s);
+
+    client_array_t *arr = vertical ? &s->spatial.byy : &s->spatial.byx;
+    int ref = vertical ? ga.y : ga.x;
+    /* The point of A we measure from */
+    int ax = dir == SPATIAL_RIGHT ? AREA_RIGHT(ga) : ga.x;
+    int ay = dir == SPATIAL_DOWN ? AREA_BOTTOM(ga) : ga.y;
+    int i = spatial_upper_bound(arr, vertical, ref);
+
+    if(!forward)
+        /* Last element strictly before ref */
+        i = spatial_upper_bound(arr, vertical, ref - 1) - 1;
+
+    for(; i >= 0 && i < arr->len; i += forward ? 1 : -1)
+    {
+        client_t *c = arr->tab[i];
+        area_t gb = c->geometry;
+        int64_t along;
+
+        /* Lower bound of the distance along the search axis. Going backward
+         * it is measured to the far border of B, which is at most the
+         * biggest width or height away from its origin. */
+        if(forward)
+            along = vertical ? gb.y - ay : gb.x - ax;
+        else if(vertical)
+            along = ay - gb.y - s->spatial.max_height;
+        else
+            along = ax - gb.x - s->spatial.max_width;
+
+        if(target && along > 0 && along * along >= dist_min)
+            break;
+
+        if(c == sel || !client_isvisible(c))
+            continue;
+
+        int bx = dir == SPATIAL_LEFT ? AREA_RIGHT(gb) : gb.x;
+        int by = dir == SPATIAL_UP ? AREA_BOTTOM(gb) : gb.y;
+        int64_t dx = bx - ax, dy = by - ay;
+        int64_t dist = dx * dx + dy * dy;
+
+        if(!target || dist < dist_min)
+        {
+            target = c;
+            dist_min = dist;
+        }
+    }
+
+    return target;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,53 @@
+/*
+ * spatial.h - spatial index of client frames header
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_SPATIAL_H
+#define AWESOME_SPATIAL_H
+
+#include "globalconf.h"
+
+/** Directions understood by spatial_find_in_direction() */
+typedef enum
+{
+    SPATIAL_UP,
+    SPATIAL_DOWN,
+    SPATIAL_LEFT,
+    SPATIAL_RIGHT
+} spatial_direction_t;
+
+/** Per screen index of client frames, sorted along both axes */
+typedef struct
+{
+    /** Clients sorted by their left edge */
+    client_array_t byx;
+    /** Clients sorted by their top edge */
+    client_array_t byy;
+    /** Biggest client width and height, used to bound searches */
+    uint16_t max_width, max_height;
+    /** Does the index need to be rebuilt? */
+    bool need_update;
+} spatial_index_t;
+
+void spatial_need_update(screen_t *);
+client_t *spatial_find_in_direction(client_t *, spatial_direction_t);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
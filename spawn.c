@@ -21,8 +21,11 @@
 
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 
 #include <glib.h>
 
@@ -34,6 +37,48 @@
 /** 20 seconds timeout */
 #define AWESOME_SPAWN_TIMEOUT 20.0
 
+/** Size of the chunks read from a spawned process output */
+#define SPAWN_READ_SIZE 4096
+
+typedef struct spawn_process_t spawn_process_t;
+
+/** An output stream of a spawned process */
+typedef struct
+{
+    /** The watcher on the pipe */
+    ev_io io;
+    /** Partial line not yet delivered, in line mode */
+    buffer_t buf;
+    /** The Lua callback receiving the data */
+    int callback;
+    /** The process this stream belongs to */
+    spawn_process_t *process;
+} spawn_stream_t;
+
+/** A process spawned by awesome */
+struct spawn_process_t
+{
+    /** The process id */
+    GPid pid;
+    /** When the process was started */
+    ev_tstamp started;
+    /** The child watcher */
+    ev_child child;
+    /** The stdout and stderr streams */
+    spawn_stream_t out, err;
+    /** The Lua callback called on exit */
+    int exit_callback;
+    /** Deliver output line by line instead of by chunks */
+    bool line_mode;
+    /** The exit status, valid once the child exited */
+    int status;
+    /** Number of watchers still running */
+    int watchers;
+};
+
+/** Resource usage of the children reaped so far */
+static struct rusage spawn_rusage;
+
 /** Wrapper for unrefing startup sequence.
  */
 static inline void
@@ -248,8 +293,11 @@ spawn_init(void)
     signal_add(&global_signals, "spawn::canceled");
     signal_add(&global_signals, "spawn::change");
     signal_add(&global_signals, "spawn::completed");
+    signal_add(&global_signals, "spawn::exited");
     signal_add(&global_signals, "spawn::initiated");
     signal_add(&global_signals, "spawn::timeout");
+
+    getrusage(RUSAGE_CHILDREN, &spawn_rusage);
 }
 
 static void
@@ -266,31 +314,265 @@ spawn_callback(gpointer user_data)
     setsid();
 }
 
+/** Release a watcher of a spawned process.
+ * Once the child exited and both streams reached end of file, the exit
+ * callback is called and the process is freed. Delaying the exit callback
+ * until then guarantees that all the output has been delivered before it.
+ * \param process The process.
+ */
+static void
+spawn_process_unref(spawn_process_t *process)
+{
+    lua_State *L = globalconf.L;
+
+    if(--process->watchers > 0)
+        return;
+
+    if(process->exit_callback != LUA_REFNIL)
+    {
+        if(WIFSIGNALED(process->status))
+        {
+            lua_pushliteral(L, "signal");
+            lua_pushnumber(L, WTERMSIG(process->status));
+        }
+        else
+        {
+            lua_pushliteral(L, "exit");
+            lua_pushnumber(L, WEXITSTATUS(process->status));
+        }
+        luaA_dofunction_from_registry(L, process->exit_callback, 2, 0);
+    }
+
+    luaA_unregister(L, &process->exit_callback);
+    luaA_unregister(L, &process->out.callback);
+    luaA_unregister(L, &process->err.callback);
+    buffer_wipe(&process->out.buf);
+    buffer_wipe(&process->err.buf);
+    g_spawn_close_pid(process->pid);
+    p_delete(&process);
+}
+
+/** Deliver data read from a stream to its Lua callback.
+ * \param stream The stream.
+ * \param data The data.
+ * \param len The data length.
+ */
+static void
+spawn_stream_emit(spawn_stream_t *stream, const char *data, size_t len)
+{
+    lua_pushlstring(globalconf.L, data, len);
+    luaA_dofunction_from_registry(globalconf.L, stream->callback, 1, 0);
+}
+
+/** Deliver all the complete lines buffered in a stream.
+ * \param stream The stream.
+ */
+static void
+spawn_stream_emit_lines(spawn_stream_t *stream)
+{
+    const char *line = stream->buf.s, *end = stream->buf.s + stream->buf.len, *nl;
+
+    while((nl = memchr(line, '\n', end - line)))
+    {
+        spawn_stream_emit(stream, line, nl - line);
+        line = nl + 1;
+    }
+
+    buffer_splice(&stream->buf, 0, line - stream->buf.s, NULL, 0);
+}
+
+/** Read what is available on a spawned process stream.
+ * \param loop The event loop.
+ * \param w The io watcher.
+ * \param revents The events.
+ */
+static void
+spawn_stream_cb(struct ev_loop *loop, ev_io *w, int revents)
+{
+    spawn_stream_t *stream = w->data;
+    char chunk[SPAWN_READ_SIZE];
+    ssize_t len = read(w->fd, chunk, sizeof(chunk));
+
+    if(len < 0 && (errno == EAGAIN || errno == EINTR))
+        return;
+
+    if(len > 0)
+    {
+        if(stream->process->line_mode)
+        {
+            buffer_add(&stream->buf, chunk, len);
+            spawn_stream_emit_lines(stream);
+        }
+        else
+            spawn_stream_emit(stream, chunk, len);
+        return;
+    }
+
+    /* End of file or error: flush the last unterminated line */
+    if(stream->buf.len)
+    {
+        spawn_stream_emit(stream, stream->buf.s, stream->buf.len);
+        buffer_splice(&stream->buf, 0, stream->buf.len, NULL, 0);
+    }
+
+    ev_io_stop(loop, w);
+    close(w->fd);
+    spawn_process_unref(stream->process);
+}
+
+/** Emit the spawn::exited signal for a terminated process.
+ * \param process The process.
+ * \param rusage The resources used by the process.
+ */
+static void
+spawn_emit_exited(spawn_process_t *process, const struct rusage *rusage)
+{
+    lua_State *L = globalconf.L;
+
+    lua_createtable(L, 0, 6);
+    lua_pushnumber(L, process->pid);
+    lua_setfield(L, -2, "pid");
+    if(WIFSIGNALED(process->status))
+    {
+        lua_pushnumber(L, WTERMSIG(process->status));
+        lua_setfield(L, -2, "signal");
+    }
+    else
+    {
+        lua_pushnumber(L, WEXITSTATUS(process->status));
+        lua_setfield(L, -2, "exit_code");
+    }
+    lua_pushnumber(L, ev_time() - process->started);
+    lua_setfield(L, -2, "wall_time");
+    lua_pushnumber(L, rusage->ru_utime.tv_sec + rusage->ru_utime.tv_usec / 1000000.);
+    lua_setfield(L, -2, "user_time");
+    lua_pushnumber(L, rusage->ru_stime.tv_sec + rusage->ru_stime.tv_usec / 1000000.);
+    lua_setfield(L, -2, "system_time");
+
+    signal_object_emit(L, &global_signals, "spawn::exited", 1);
+}
+
+/** Handle the termination of a spawned process.
+ * libev reaps children itself with waitpid(), so the resource usage of the
+ * process is computed from the growth of the RUSAGE_CHILDREN counters since
+ * the last reap. The child watcher runs at maximum priority so that it is
+ * invoked before libev reaps the next child.
+ * \param loop The event loop.
+ * \param w The child watcher.
+ * \param revents The events.
+ */
+static void
+spawn_child_cb(struct ev_loop *loop, ev_child *w, int revents)
+{
+    spawn_process_t *process = w->data;
+    struct rusage now, used;
+
+    ev_child_stop(loop, w);
+    process->status = w->rstatus;
+
+    getrusage(RUSAGE_CHILDREN, &now);
+    p_clear(&used, 1);
+    timersub(&now.ru_utime, &spawn_rusage.ru_utime, &used.ru_utime);
+    timersub(&now.ru_stime, &spawn_rusage.ru_stime, &used.ru_stime);
+    spawn_rusage = now;
+
+    spawn_emit_exited(process, &used);
+    spawn_process_unref(process);
+}
+
+/** Start watching one output stream of a spawned process.
+ * \param process The process.
+ * \param stream The stream.
+ * \param fd The read end of the pipe.
+ */
+static void
+spawn_stream_start(spawn_process_t *process, spawn_stream_t *stream, int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    buffer_init(&stream->buf);
+    stream->process = process;
+    ev_io_init(&stream->io, spawn_stream_cb, fd, EV_READ);
+    stream->io.data = stream;
+    ev_io_start(globalconf.loop, &stream->io);
+    process->watchers++;
+}
+
 /** Spawn a command.
  * \param command_line The command line to launch.
+ * \param process The process to fill and watch.
  * \param error A error pointer to fill with the possible error from
  * g_spawn_async.
  * \return g_spawn_async value.
  */
 static GPid
-spawn_command(const gchar *command_line, GError **error)
+spawn_command(const gchar *command_line, spawn_process_t *process, GError **error)
 {
     gboolean retval;
     GPid pid;
     gchar **argv = 0;
+    int out_fd = -1, err_fd = -1;
 
     if(!g_shell_parse_argv(command_line, NULL, &argv, error))
         return 0;
 
-    retval = g_spawn_async(NULL, argv, NULL, G_SPAWN_SEARCH_PATH,
-                           spawn_callback, NULL, &pid, error);
+    retval = g_spawn_async_with_pipes(NULL, argv, NULL,
+                                      G_SPAWN_SEARCH_PATH | G_SPAWN_DO_NOT_REAP_CHILD,
+                                      spawn_callback, NULL, &pid, NULL,
+                                      process->out.callback != LUA_REFNIL ? &out_fd : NULL,
+                                      process->err.callback != LUA_REFNIL ? &err_fd : NULL,
+                                      error);
     g_strfreev (argv);
 
     if (!retval)
         return 0;
+
+    process->pid = pid;
+    process->started = ev_time();
+    if(out_fd >= 0)
+        spawn_stream_start(process, &process->out, out_fd);
+    if(err_fd >= 0)
+        spawn_stream_start(process, &process->err, err_fd);
+    ev_child_init(&process->child, spawn_child_cb, pid, 0);
+    ev_set_priority(&process->child, EV_MAXPRI);
+    process->child.data = process;
+    ev_child_start(globalconf.loop, &process->child);
+    process->watchers++;
+
     return pid;
 }
 
+/** Create a new process.
+ * \param L The Lua VM state.
+ * \param idx The index of the table of callbacks given to awesome.spawn(),
+ * or 0 if there is none.
+ * \return A new process.
+ */
+static spawn_process_t *
+spawn_process_new(lua_State *L, int idx)
+{
+    spawn_process_t *process = p_new(spawn_process_t, 1);
+    process->out.callback = process->err.callback = process->exit_callback = LUA_REFNIL;
+
+    if(!idx)
+        return process;
+
+    lua_getfield(L, idx, "stdout");
+    if(!lua_isnil(L, -1))
+        luaA_registerfct(L, -1, &process->out.callback);
+    lua_getfield(L, idx, "stderr");
+    if(!lua_isnil(L, -1))
+        luaA_registerfct(L, -1, &process->err.callback);
+    lua_getfield(L, idx, "exit");
+    if(!lua_isnil(L, -1))
+        luaA_registerfct(L, -1, &process->exit_callback);
+    lua_getfield(L, idx, "output");
+    process->line_mode = !A_STREQ(luaL_optstring(L, -1, "line"), "chunk");
+    lua_pop(L, 4);
+
+    return process;
+}
+
 /** Spawn a program.
  * This function is multi-head (Zaphod) aware and will set display to
  * the right screen according to mouse position.
@@ -299,6 +581,9 @@ spawn_command(const gchar *command_line, GError **error)
  * \luastack
  * \lparam The command to launch.
  * \lparam Use startup-notification, true or false, default to true.
+ * \lparam An optional table of callbacks: stdout and stderr receive the
+ * output, exit receives the exit reason and code, output selects "line" or
+ * "chunk" delivery.
  * \lreturn Process ID if everything is OK, or an error string if an error occured.
  */
 int
@@ -306,12 +591,15 @@ luaA_spawn(lua_State *L)
 {
     const char *cmd;
     bool use_sn = true;
+    spawn_process_t *process;
 
     if(lua_gettop(L) >= 2)
-        use_sn = luaA_checkboolean(L, 2);
+        use_sn = luaA_optboolean(L, 2, true);
 
     cmd = luaL_checkstring(L, 1);
 
+    process = spawn_process_new(L, lua_istable(L, 3) ? 3 : 0);
+
     SnLauncherContext *context = NULL;
     if(use_sn)
     {
@@ -343,7 +631,7 @@ luaA_spawn(lua_State *L)
     }
 
     GError *error = NULL;
-    GPid pid = spawn_command(cmd, &error);
+    GPid pid = spawn_command(cmd, process, &error);
     if(!pid)
     {
         /* push error on stack */
@@ -351,6 +639,10 @@ luaA_spawn(lua_State *L)
         g_error_free(error);
         if(context)
             sn_launcher_context_complete(context);
+        /* No watcher was started, so this frees the process */
+        luaA_unregister(L, &process->exit_callback);
+        process->watchers = 1;
+        spawn_process_unref(process);
         return 1;
     }
 
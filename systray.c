@@ -134,6 +134,7 @@ systray_cleanup(void)
 
     xcb_unmap_window(globalconf.connection,
                      globalconf.systray.window);
+    globalconf.systray.mapped = false;
 }
 
 /** Handle a systray request.
@@ -146,6 +147,8 @@ systray_request_handle(xcb_window_t embed_win, xembed_info_t *info)
 {
     xembed_window_t em;
     xcb_get_property_cookie_t em_cookie;
+
+    p_clear(&em, 1);
     const uint32_t select_input_val[] =
     {
         XCB_EVENT_MASK_STRUCTURE_NOTIFY
@@ -278,30 +281,46 @@ systray_update(int base_size, bool horizontal)
         return;
 
     /* Give the systray window the correct size */
-    uint32_t config_vals[4] = { base_size, base_size, 0, 0 };
+    uint16_t width = base_size, height = base_size;
     if(horizontal)
-        config_vals[0] = base_size * globalconf.embedded.len;
+        width = base_size * globalconf.embedded.len;
     else
-        config_vals[1] = base_size * globalconf.embedded.len;
-    xcb_configure_window(globalconf.connection,
-                         globalconf.systray.window,
-                         XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
-                         config_vals);
-
-    /* Now resize each embedded window */
-    config_vals[0] = config_vals[1] = 0;
-    config_vals[2] = config_vals[3] = base_size;
+        height = base_size * globalconf.embedded.len;
+    if(width != globalconf.systray.width || height != globalconf.systray.height)
+    {
+        uint32_t config_vals[] = { width, height };
+        xcb_configure_window(globalconf.connection,
+                             globalconf.systray.window,
+                             XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
+                             config_vals);
+        globalconf.systray.width = width;
+        globalconf.systray.height = height;
+    }
+
+    /* Now resize each embedded window, only sending what changed */
+    int16_t x = 0, y = 0;
     for(int i = 0; i < globalconf.embedded.len; i++)
     {
         xembed_window_t *em = &globalconf.embedded.tab[i];
-        xcb_configure_window(globalconf.connection, em->win,
-                             XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
-                             config_vals);
-        xcb_map_window(globalconf.connection, em->win);
+        if(em->x != x || em->y != y || em->size != base_size)
+        {
+            uint32_t config_vals[] = { x, y, base_size, base_size };
+            xcb_configure_window(globalconf.connection, em->win,
+                                 XCB_CONFIG_WINDOW_X | XCB_CONFIG_WINDOW_Y | XCB_CONFIG_WINDOW_WIDTH | XCB_CONFIG_WINDOW_HEIGHT,
+                                 config_vals);
+            em->x = x;
+            em->y = y;
+            em->size = base_size;
+        }
+        if(!em->mapped)
+        {
+            xcb_map_window(globalconf.connection, em->win);
+            em->mapped = true;
+        }
         if(horizontal)
-            config_vals[0] += base_size;
+            x += base_size;
         else
-            config_vals[1] += base_size;
+            y += base_size;
     }
 }
 
@@ -329,12 +348,20 @@ luaA_systray(lua_State *L)
         const char *bg = luaL_checklstring(L, 6, &bg_len);
         color_t bg_color;
 
-        if(color_init_reply(color_init_unchecked(&bg_color, bg, bg_len)))
+        if(color_init_reply(color_init_unchecked(&bg_color, bg, bg_len))
+           && (!globalconf.systray.has_background
+               || globalconf.systray.background != bg_color.pixel))
         {
             uint32_t config_back[] = { bg_color.pixel };
             xcb_change_window_attributes(globalconf.connection,
                                          globalconf.systray.window,
                                          XCB_CW_BACK_PIXEL, config_back);
+            globalconf.systray.background = bg_color.pixel;
+            globalconf.systray.has_background = true;
+            /* The new background is only painted on exposure */
+            if(globalconf.systray.mapped)
+                xcb_clear_area(globalconf.connection, true,
+                               globalconf.systray.window, 0, 0, 0, 0);
         }
 
         if(globalconf.systray.parent == NULL)
@@ -345,7 +372,7 @@ luaA_systray(lua_State *L)
                                 globalconf.systray.window,
                                 w->window,
                                 x, y);
-        else
+        else if(globalconf.systray.x != x || globalconf.systray.y != y)
         {
             uint32_t config_vals[2] = { x, y };
             xcb_configure_window(globalconf.connection,
@@ -355,16 +382,25 @@ luaA_systray(lua_State *L)
         }
 
         globalconf.systray.parent = w;
+        globalconf.systray.x = x;
+        globalconf.systray.y = y;
 
         if(globalconf.embedded.len != 0)
         {
             systray_update(base_size, horiz);
-            xcb_map_window(globalconf.connection,
-                           globalconf.systray.window);
+            if(!globalconf.systray.mapped)
+            {
+                xcb_map_window(globalconf.connection,
+                               globalconf.systray.window);
+                globalconf.systray.mapped = true;
+            }
         }
-        else
+        else if(globalconf.systray.mapped)
+        {
             xcb_unmap_window(globalconf.connection,
                              globalconf.systray.window);
+            globalconf.systray.mapped = false;
+        }
     }
 
     lua_pushnumber(L, globalconf.embedded.len);
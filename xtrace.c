@@ -0,0 +1,393 @@
+/*
+ * xtrace.c - X request and round trip accounting
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* When built with WITH_XCB_TRACE, this file defines xcb_send_request(),
+ * xcb_wait_for_reply() and xcb_request_check(). Since awesome is linked with
+ * -export-dynamic, these definitions take precedence over the ones of libxcb,
+ * also for the calls libxcb and the xcb-util libraries make themselves. They
+ * account the request or round trip to the code in awesome which caused it,
+ * and then call the real libxcb function.
+ */
+
+#define _GNU_SOURCE
+
+#include "xtrace.h"
+#include "luaa.h"
+
+#ifdef WITH_XCB_TRACE
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <xcb/xcbext.h>
+#include <xcb/xcb_aux.h>
+#include <xcb/xcb_event.h>
+
+#include "globalconf.h"
+
+/** Maximum depth of the stack searched for the caller */
+#define XTRACE_STACK_SIZE 12
+
+/** The X activity caused by one call site */
+typedef struct
+{
+    /** The return address in awesome */
+    void *site;
+    /** Number of requests sent */
+    unsigned int requests;
+    /** Number of replies or errors waited for */
+    unsigned int round_trips;
+    /** Number of round trips during event dispatch or refresh */
+    unsigned int in_loop;
+} xtrace_site_t;
+
+static inline int
+xtrace_site_cmp(const void *a, const void *b)
+{
+    const xtrace_site_t *x = a, *y = b;
+    return x->site > y->site ? 1 : (x->site < y->site ? -1 : 0);
+}
+
+DO_BARRAY(xtrace_site_t, xtrace_site, DO_NOTHING, xtrace_site_cmp)
+
+/** Requests sent to an extension */
+typedef struct
+{
+    const char *name;
+    unsigned int count;
+} xtrace_extension_t;
+
+DO_ARRAY(xtrace_extension_t, xtrace_extension, DO_NOTHING)
+
+const char *xtrace_phase = NULL;
+
+static struct
+{
+    bool enabled;
+    /** Base address of the awesome executable */
+    void *base;
+    xtrace_site_array_t sites;
+    /** Total number of round trips */
+    unsigned int round_trips;
+    /** Core requests, by major opcode */
+    unsigned int core[256];
+    xtrace_extension_array_t extensions;
+} xtrace;
+
+/** Find the call site in awesome responsible for the current X activity.
+ * This is the innermost frame of the awesome executable itself, skipping the
+ * frames in libxcb and xcb-util.
+ * \param stack The backtrace taken by the interposed function.
+ * \param size The number of frames in the backtrace.
+ * \return The call site statistics.
+ */
+static xtrace_site_t *
+xtrace_site_get(void **stack, int size)
+{
+    xtrace_site_t key = { .site = NULL };
+    xtrace_site_t *site;
+
+    /* Frame 0 is the interposed function itself */
+    for(int i = 1; i < size; i++)
+    {
+        Dl_info info;
+        if(dladdr(stack[i], &info) && info.dli_fbase == xtrace.base)
+        {
+            key.site = stack[i];
+            break;
+        }
+    }
+
+    if(!(site = xtrace_site_array_lookup(&xtrace.sites, &key)))
+    {
+        xtrace_site_array_insert(&xtrace.sites, key);
+        site = xtrace_site_array_lookup(&xtrace.sites, &key);
+    }
+
+    return site;
+}
+
+/** Get the name of a call site.
+ * \param site The return address.
+ * \return A new string, to be freed with p_delete().
+ */
+static char *
+xtrace_site_name(void *site)
+{
+    char **symbols;
+    char *name;
+
+    if(!site)
+        return a_strdup("unknown");
+
+    if(!(symbols = backtrace_symbols(&site, 1)))
+        return a_strdup("unknown");
+
+    name = a_strdup(symbols[0]);
+    p_delete(&symbols);
+    return name;
+}
+
+/** Account a round trip.
+ * \param stack The backtrace taken by the interposed function.
+ * \param size The number of frames in the backtrace.
+ */
+static void
+xtrace_round_trip(void **stack, int size)
+{
+    xtrace_site_t *site = xtrace_site_get(stack, size);
+
+    xtrace.round_trips++;
+    site->round_trips++;
+    if(xtrace_phase && site->in_loop++ == 0)
+    {
+        char *name = xtrace_site_name(site->site);
+        warn("X round trip during %s, from %s", xtrace_phase, name);
+        p_delete(&name);
+    }
+}
+
+unsigned int
+xcb_send_request(xcb_connection_t *c, int flags, struct iovec *vector,
+                 const xcb_protocol_request_t *request)
+{
+    static unsigned int (*real)(xcb_connection_t *, int, struct iovec *,
+                                const xcb_protocol_request_t *);
+
+    if(!real)
+        real = dlsym(RTLD_NEXT, "xcb_send_request");
+
+    if(xtrace.enabled)
+    {
+        void *stack[XTRACE_STACK_SIZE];
+        int size = backtrace(stack, countof(stack));
+
+        xtrace_site_get(stack, size)->requests++;
+
+        if(!request->ext)
+            xtrace.core[request->opcode]++;
+        else
+        {
+            xtrace_extension_t *ext = NULL;
+
+            foreach(e, xtrace.extensions)
+                if(A_STREQ(e->name, request->ext->name))
+                {
+                    ext = e;
+                    break;
+                }
+
+            if(ext)
+                ext->count++;
+            else
+                xtrace_extension_array_append(&xtrace.extensions,
+                                              (xtrace_extension_t) { request->ext->name, 1 });
+        }
+    }
+
+    return real(c, flags, vector, request);
+}
+
+void *
+xcb_wait_for_reply(xcb_connection_t *c, unsigned int request, xcb_generic_error_t **e)
+{
+    static void *(*real)(xcb_connection_t *, unsigned int, xcb_generic_error_t **);
+
+    if(!real)
+        real = dlsym(RTLD_NEXT, "xcb_wait_for_reply");
+
+    if(xtrace.enabled)
+    {
+        void *stack[XTRACE_STACK_SIZE];
+        xtrace_round_trip(stack, backtrace(stack, countof(stack)));
+    }
+
+    return real(c, request, e);
+}
+
+xcb_generic_error_t *
+xcb_request_check(xcb_connection_t *c, xcb_void_cookie_t cookie)
+{
+    static xcb_generic_error_t *(*real)(xcb_connection_t *, xcb_void_cookie_t);
+
+    if(!real)
+        real = dlsym(RTLD_NEXT, "xcb_request_check");
+
+    if(xtrace.enabled)
+    {
+        void *stack[XTRACE_STACK_SIZE];
+        xtrace_round_trip(stack, backtrace(stack, countof(stack)));
+    }
+
+    return real(c, cookie);
+}
+
+void
+xtrace_reset(void)
+{
+    xtrace_site_array_wipe(&xtrace.sites);
+    xtrace_site_array_init(&xtrace.sites);
+    xtrace_extension_array_wipe(&xtrace.extensions);
+    xtrace_extension_array_init(&xtrace.extensions);
+    p_clear(xtrace.core, countof(xtrace.core));
+    xtrace.round_trips = 0;
+}
+
+/** Start counting X requests and round trips.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lreturn True if supported, false if libxcb calls cannot be traced.
+ */
+int
+luaA_xtrace_start(lua_State *L)
+{
+    Dl_info info;
+    unsigned int before;
+
+    if(dladdr((void *) luaA_xtrace_start, &info))
+        xtrace.base = info.dli_fbase;
+
+    xtrace.enabled = true;
+
+    /* Check that the round trips inside libxcb are really seen: this fails if
+     * libxcb was linked with -Bsymbolic-functions */
+    const char *phase = xtrace_enter(NULL);
+    before = xtrace.round_trips;
+    xcb_aux_sync(globalconf.connection);
+    xtrace_leave(phase);
+    if(xtrace.round_trips == before)
+    {
+        warn("libxcb does not allow tracing round trips");
+        xtrace.enabled = false;
+    }
+
+    xtrace_reset();
+    lua_pushboolean(L, xtrace.enabled);
+    return 1;
+}
+
+/** Stop counting X requests and round trips.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_xtrace_stop(lua_State *L)
+{
+    xtrace.enabled = false;
+    return 0;
+}
+
+/** Get the X requests and round trips of each call site.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ * \luastack
+ * \lreturn A table of tables with the site, requests, round_trips and in_loop
+ * fields.
+ */
+int
+luaA_xtrace_sites(lua_State *L)
+{
+    lua_createtable(L, xtrace.sites.len, 0);
+    for(int i = 0; i < xtrace.sites.len; i++)
+    {
+        xtrace_site_t *site = &xtrace.sites.tab[i];
+        char *name = xtrace_site_name(site->site);
+
+        lua_createtable(L, 0, 4);
+        lua_pushstring(L, name);
+        lua_setfield(L, -2, "site");
+        lua_pushnumber(L, site->requests);
+        lua_setfield(L, -2, "requests");
+        lua_pushnumber(L, site->round_trips);
+        lua_setfield(L, -2, "round_trips");
+        lua_pushnumber(L, site->in_loop);
+        lua_setfield(L, -2, "in_loop");
+        lua_rawseti(L, -2, i + 1);
+
+        p_delete(&name);
+    }
+    return 1;
+}
+
+/** Get the number of X requests sent, by request or extension name.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+luaA_xtrace_requests(lua_State *L)
+{
+    lua_newtable(L);
+    for(int opcode = 0; opcode < countof(xtrace.core); opcode++)
+        if(xtrace.core[opcode])
+        {
+            const char *label = xcb_event_get_request_label(opcode);
+            if(label)
+                lua_pushstring(L, label);
+            else
+                lua_pushnumber(L, opcode);
+            lua_pushnumber(L, xtrace.core[opcode]);
+            lua_rawset(L, -3);
+        }
+    foreach(ext, xtrace.extensions)
+    {
+        lua_pushnumber(L, ext->count);
+        lua_setfield(L, -2, ext->name);
+    }
+    return 1;
+}
+
+#else
+
+void
+xtrace_reset(void)
+{
+}
+
+int
+luaA_xtrace_start(lua_State *L)
+{
+    lua_pushboolean(L, false);
+    return 1;
+}
+
+int
+luaA_xtrace_stop(lua_State *L)
+{
+    return 0;
+}
+
+int
+luaA_xtrace_sites(lua_State *L)
+{
+    lua_newtable(L);
+    return 1;
+}
+
+int
+luaA_xtrace_requests(lua_State *L)
+{
+    lua_newtable(L);
+    return 1;
+}
+
+#endif
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,73 @@
+/*
+ * xtrace.h - X request and round trip accounting header
+ *
+ * Copyright © 2013 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+#ifndef AWESOME_XTRACE_H
+#define AWESOME_XTRACE_H
+
+#include <stddef.h>
+#include <lua.h>
+
+#include "config.h"
+
+void xtrace_reset(void);
+int luaA_xtrace_start(lua_State *);
+int luaA_xtrace_stop(lua_State *);
+int luaA_xtrace_sites(lua_State *);
+int luaA_xtrace_requests(lua_State *);
+
+#ifdef WITH_XCB_TRACE
+/** What the main loop is doing, NULL outside event dispatch and refresh */
+extern const char *xtrace_phase;
+
+/** Mark the start of a main loop phase in which round trips are reported.
+ * \param phase The phase name.
+ * \return The previous phase, to be given to xtrace_leave().
+ */
+static inline const char *
+xtrace_enter(const char *phase)
+{
+    const char *previous = xtrace_phase;
+    xtrace_phase = phase;
+    return previous;
+}
+
+/** Mark the end of a main loop phase.
+ * \param previous The value returned by xtrace_enter().
+ */
+static inline void
+xtrace_leave(const char *previous)
+{
+    xtrace_phase = previous;
+}
+#else
+static inline const char *
+xtrace_enter(const char *phase)
+{
+    return NULL;
+}
+
+static inline void
+xtrace_leave(const char *previous)
+{
+}
+#endif
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80